@@ -1,24 +1,89 @@
+#include "../common/arena.h"
+#include "../common/bucket_queue.h"
+#include "../common/cycle_breaker.h"
+#include "../common/fit_index.h"
+#include "../common/plan_stream.h"
 #include "../common/solution.h"
+#include "../common/workspace.h"
 #include "../testenv_lib/algo_stat_maker.h"
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <map>
 #include <optional>
 #include <queue>
+#include <span>
+#include <thread>
 #include <vector>
 
 #include "parallelizer.h"
 
+// StreamX emits the plan of SolveX movement by movement while it is being built (see PlanStream)
+
 namespace AlgoBaseline {
-	std::optional<Solution> Solve(const Problem& problem, AlgoStatMaker* stats);
+	std::optional<Solution> Solve(const Problem& problem, AlgoStatMaker* stats, SolverWorkspace* workspace);
+	PlanStream Stream(const Problem& problem, AlgoStatMaker* stats, SolverWorkspace* workspace);
 }
 
 namespace AlgoParallelBaseline {
-	std::optional<Solution> Solve(const Problem& problem, AlgoStatMaker* stats);
+	std::optional<Solution> Solve(const Problem& problem, AlgoStatMaker* stats, SolverWorkspace* workspace);
+	PlanStream Stream(const Problem& problem, AlgoStatMaker* stats, SolverWorkspace* workspace);
 }
 
 namespace AlgoFlowGrouping {
-	std::optional<Solution> Solve(const Problem& problem, AlgoStatMaker* stats);
+	std::optional<Solution> Solve(const Problem& problem, AlgoStatMaker* stats, SolverWorkspace* workspace);
+	PlanStream Stream(const Problem& problem, AlgoStatMaker* stats, SolverWorkspace* workspace);
+	// rounds are min-cost maximum flows preferring long migrations and busy servers
+	std::optional<Solution> SolveMinCost(const Problem& problem, AlgoStatMaker* stats, SolverWorkspace* workspace);
+	PlanStream StreamMinCost(const Problem& problem, AlgoStatMaker* stats, SolverWorkspace* workspace);
+	// continuous-time planning: moves start as soon as channels free up, no rounds and no parallelizer
+	std::optional<Solution> SolveEventDriven(const Problem& problem, AlgoStatMaker* stats, SolverWorkspace* workspace);
+	PlanStream StreamEventDriven(const Problem& problem, AlgoStatMaker* stats, SolverWorkspace* workspace);
+	// event-driven, minimizes the priority-weighted sum of completion times and chases deadlines
+	std::optional<Solution> SolveWeightedCompletion(const Problem& problem, AlgoStatMaker* stats, SolverWorkspace* workspace);
+	PlanStream StreamWeightedCompletion(const Problem& problem, AlgoStatMaker* stats, SolverWorkspace* workspace);
+}
+
+namespace AlgoDependencyGraph {
+	std::optional<Solution> Solve(const Problem& problem, AlgoStatMaker* stats, SolverWorkspace* workspace);
+}
+
+namespace AlgoExact {
+	constexpr size_t kMaxSearchVMs = 16; // larger components are refused
+
+	enum class Objective {
+		kMemoryMoved, // total memory of all moves, buffer hops included
+		kMigrationTime // total migration time, i.e. makespan of the sequential plan
+	};
+
+	struct SearchLimits {
+		size_t max_nodes = 200000;
+		std::chrono::milliseconds time_limit{50}; // zero for none; a hit makes the result depend on timing
+		size_t threads = std::max(1u, std::thread::hardware_concurrency()); // more than one: result depends on scheduling
+		size_t buffer_servers = 2; // emptiest servers outside of the component usable as buffers
+	};
+
+	// for calls from inside solvers: one thread and a node budget only, so the plan depends on the input alone
+	inline const SearchLimits kSolverLimits{
+		.max_nodes = 100000,
+		.time_limit = std::chrono::milliseconds::zero(),
+		.threads = 1
+	};
+
+	struct SearchResult {
+		std::vector<Movement> moves; // sequential, starting at 0
+		double cost = 0;
+		bool found = false;
+		bool optimal = false; // false if a limit was hit
+		size_t nodes = 0;
+	};
+
+	// optimal rearrangement of the VMs misplaced at `vm_pos` (server of every VM, e.g. the start
+	// position or a solver's current one), servers not involved are only used as buffers
+	SearchResult SearchSchedule(
+		const Problem& problem, std::span<const size_t> vm_pos, Objective objective, const SearchLimits& limits = {}
+	);
 }
 
 namespace AlgoLowerBound {
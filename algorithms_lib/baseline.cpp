@@ -4,79 +4,90 @@
 
 namespace AlgoBaseline {
 
-struct cmp_by_mem {
-	bool operator()(const VM& lhs, const VM& rhs) const {
-		if (lhs.mem != rhs.mem) {
-			return lhs.mem > rhs.mem;
-		}
-		return lhs.id < rhs.id;
-	}
+struct Scratch {
+	SolveArena arena;
+	SolutionBuilder solution;
+	std::vector<size_t> vm_pos;
+	std::vector<Server> servers;
+	FitIndex fit_index;
+	MemoryBucketQueue misplaced_vms;
+	MemoryBucketQueue available_for_migration;
+	CycleBreaker cycle_breaker;
+	std::vector<size_t> targets;
+	std::vector<size_t> vm_sorted_by_mem;
+	std::vector<Movement> planned; // not emitted yet
 };
 
-std::optional<Solution> Solve(const Problem& problem, AlgoStatMaker* statmaker) {
+PlanStream Stream(const Problem& problem, AlgoStatMaker* statmaker, SolverWorkspace* workspace) {
 	/*
 		M := (Set of misplaced VMs) is decreasing.
 		Keep A := (set of misplaced VMs that can move to their destination right now).
 		Take one VM, perform step, change A.
-		if A is empty -> find minimal VM in M (in terms of memory), free some space for it
-			by moving misplaced VMs from destination server to buffer, go greedy in order
-			of increasing VMs' memory. Move this minimal VM.
+		if A is empty -> find disjoint cycles of waiting VMs and the minimal VM (in terms of memory)
+			of each, free some space for them by moving misplaced VMs from their destination servers
+			to buffers outside of the cycles, go greedy in order of increasing VMs' memory.
+			Evictions of all cycles run in parallel, then continue with A.
+		Every move is final once planned, so it is emitted right away; a group of evictions is
+		emitted in order of start moments when the whole group is planned.
 	*/
 
 	AlgoStat stats;
 
-	long double timer = 0;
-	Solution solution(problem.vms.size());
+	SolverWorkspace local_workspace;
+	Scratch& scratch = (workspace ? workspace : &local_workspace)->Get<Scratch>();
 
-	std::vector<size_t> vm_pos = problem.start_position.vm_server;
-	std::vector<Server> servers;
-	std::vector<Server> servers_end_pos;
-	servers.reserve(problem.server_specs.size());
-	servers_end_pos.reserve(problem.server_specs.size());
+	TimeMoment timer = 0;
+	std::vector<Movement>& planned = scratch.planned;
+	planned.clear();
 
-	for (size_t i = 0; i < problem.server_specs.size(); ++i) {
-		servers.emplace_back(problem.server_specs[i], i);
-		servers_end_pos.emplace_back(problem.server_specs[i], i);
-	}
+	std::vector<size_t>& vm_pos = scratch.vm_pos;
+	vm_pos.assign(problem.start_position.vm_server.begin(), problem.start_position.vm_server.end());
+
+	std::vector<Server>& servers = scratch.servers;
+	ResetServers(&servers, problem.server_specs, scratch.arena.Resource());
+
+	MemoryBucketQueue& misplaced_vms = scratch.misplaced_vms;
+	MemoryBucketQueue& available_for_migration = scratch.available_for_migration;
+	misplaced_vms.Reset(problem.vms.Table());
+	available_for_migration.Reset(misplaced_vms);
+	scratch.arena.Reset();
 
 	// init
 
 	for (const auto& vm : problem.vms) {
 		servers[vm_pos[vm.id]].ReceiveVM(vm);
 		servers[vm_pos[vm.id]].CancelReceivingVM(vm);
-
-		servers_end_pos[problem.end_position.vm_server[vm.id]].ReceiveVM(vm);
-		servers_end_pos[problem.end_position.vm_server[vm.id]].CancelReceivingVM(vm);
 	}
 
+	FitIndex& fit_index = scratch.fit_index;
+	fit_index.Reset(problem, servers);
+
 	auto cmp_vm_ids_by_mem = [&](size_t lhs, size_t rhs) {
-		if (problem.vms[lhs].mem != problem.vms[rhs].mem) {
-			return problem.vms[lhs].mem > problem.vms[rhs].mem;
+		if (problem.vms.Table().Mem(lhs) != problem.vms.Table().Mem(rhs)) {
+			return problem.vms.Table().Mem(lhs) > problem.vms.Table().Mem(rhs);
 		}
 
 		return lhs < rhs;
 	};
 
-	std::set<VM, cmp_by_mem> misplaced_vms;
-	std::set<VM, cmp_by_mem> available_for_migration;
+	for (size_t server_id = 0; server_id < servers.size(); ++server_id) {
+		fit_index.ForEachIncoming(server_id, [&](size_t vm_id, bool fits) {
+			if (vm_pos[vm_id] != server_id) {
+				misplaced_vms.Insert(vm_id);
 
-	for (const auto& vm : problem.vms) {
-		size_t end_pos = problem.end_position.vm_server[vm.id];
-
-		if (end_pos != problem.start_position.vm_server[vm.id]) {
-			misplaced_vms.insert(problem.vms[vm.id]);
-
-			if (servers[end_pos].CanFit(problem.vms[vm.id])) {
-				available_for_migration.insert(problem.vms[vm.id]);
+				if (fits) {
+					available_for_migration.Insert(vm_id);
+				}
 			}
-		}
+		});
 	}
 
-	auto perform_move = [&](size_t vm_id, size_t from, size_t to) {
+	// returns the moment the move ends
+	auto perform_move = [&](size_t vm_id, size_t from, size_t to, TimeMoment start) {
 		vm_pos[vm_id] = to;
 
 		if (from == to) {
-			return;
+			return start;
 		}
 
 		++stats.totalMigrations;
@@ -85,102 +96,123 @@ std::optional<Solution> Solve(const Problem& problem, AlgoStatMaker* statmaker)
 		servers[to].ReceiveVM(problem.vms[vm_id]);
 		servers[from].CancelSendingVM(problem.vms[vm_id]);
 		servers[to].CancelReceivingVM(problem.vms[vm_id]);
+		fit_index.UpdateServer(from);
+		fit_index.UpdateServer(to);
 
-		solution.vm_movements[vm_id].push_back(Movement{
-			.from = from,
-			.to = to,
-			.start_moment = timer,
-			.duration = problem.vms[vm_id].migration_time,
-			.vm_id = vm_id
+		TimeMoment duration = MigrationDuration(problem, vm_id, from, to);
+		planned.push_back(Movement{
+			static_cast<uint32_t>(from), static_cast<uint32_t>(to), static_cast<uint32_t>(vm_id), start, duration
 		});
 
-		timer += problem.vms[vm_id].migration_time;
-
 		// recalculate available_for_migration
 
-		for (auto vm_id : *servers_end_pos[from].GetRawVMSet()) {
-			if (
-				servers[from].CanFit(problem.vms[vm_id]) &&
-				misplaced_vms.contains(problem.vms[vm_id])
-			) {
-				available_for_migration.insert(problem.vms[vm_id]);
+		fit_index.ForEachIncoming(from, [&](size_t vm_id, bool fits) {
+			if (fits && misplaced_vms.Contains(vm_id)) {
+				available_for_migration.Insert(vm_id);
 			}
-		}
+		});
 
-		for (auto vm_id : *servers_end_pos[to].GetRawVMSet()) {
-			if (
-				available_for_migration.contains(problem.vms[vm_id]) &&
-				!servers[to].CanFit(problem.vms[vm_id])
-			) {
-				available_for_migration.erase(problem.vms[vm_id]);
+		fit_index.ForEachIncoming(to, [&](size_t vm_id, bool fits) {
+			if (!fits) {
+				available_for_migration.Erase(vm_id);
 			}
-		}
+		});
+
+		return start + duration;
 	};
 
+	CycleBreaker& cycle_breaker = scratch.cycle_breaker;
+	std::vector<size_t>& targets = scratch.targets;
+
 	// perform consecutive moves using buffer server
 
-	while (!misplaced_vms.empty()) {
-		if (available_for_migration.empty()) {
-			// break the cycle, use buffer
-			VM move_vm = *misplaced_vms.rbegin();
+	while (!misplaced_vms.Empty()) {
+		if (available_for_migration.Empty()) {
+			// break the cycles, use buffers
+			targets = cycle_breaker.FindCycles(problem, vm_pos, misplaced_vms);
+			if (targets.empty()) {
+				targets.push_back(misplaced_vms.Back());
+			}
 
-			++stats.brokenCycles;
+			for (size_t target : targets) {
+				const VM& move_vm = problem.vms[target];
+				size_t dest_server = problem.end_position.vm_server[move_vm.id];
 
-			size_t dest_server = problem.end_position.vm_server[move_vm.id];
+				++stats.brokenCycles;
 
-			std::set<size_t>& raw_vms = *servers[dest_server].GetRawVMSet();
+				std::pmr::set<size_t>& raw_vms = *servers[dest_server].GetRawVMSet();
 
-			std::vector<size_t> vm_sorted_by_mem(raw_vms.begin(), raw_vms.end());
-			std::sort(vm_sorted_by_mem.begin(), vm_sorted_by_mem.end(), cmp_vm_ids_by_mem);
-			std::reverse(vm_sorted_by_mem.begin(), vm_sorted_by_mem.end());
+				std::vector<size_t>& vm_sorted_by_mem = scratch.vm_sorted_by_mem;
+				vm_sorted_by_mem.assign(raw_vms.begin(), raw_vms.end());
+				std::sort(vm_sorted_by_mem.begin(), vm_sorted_by_mem.end(), cmp_vm_ids_by_mem);
+				std::reverse(vm_sorted_by_mem.begin(), vm_sorted_by_mem.end());
 
-			size_t ptr_servers = 0;
+				size_t ptr_servers = 0;
 
-			for (auto vm_id : vm_sorted_by_mem) {
-				if (dest_server == problem.end_position.vm_server[vm_id]) {
-					continue;
-				}
-				// find buffer server
-				size_t iters = 0;
-				while (iters != servers.size()) {
-					if (servers[ptr_servers].CanFit(problem.vms[vm_id]) && ptr_servers != dest_server) {
-						++stats.migrationsBreakingCycles;
-						perform_move(vm_id, dest_server, ptr_servers);
+				for (auto vm_id : vm_sorted_by_mem) {
+					if (dest_server == problem.end_position.vm_server[vm_id]) {
+						continue;
+					}
+					// find buffer server, preferably off the cycles
+					const VM& vm = problem.vms[vm_id];
+					size_t buffer = fit_index.FindHost(vm, ptr_servers, dest_server, cycle_breaker.CycleServers());
+					if (buffer == FitIndex::kNone) {
+						buffer = fit_index.FindHost(vm, ptr_servers, dest_server);
+					}
+					if (buffer == FitIndex::kNone) {
 						break;
-					} else {
-						++iters;
-						ptr_servers = (ptr_servers + 1) % servers.size();
 					}
-				}
 
-				if (!available_for_migration.empty()) {
-					break;
-				}
+					ptr_servers = buffer;
+					++stats.migrationsBreakingCycles;
+					TimeMoment duration = MigrationDuration(problem, vm_id, dest_server, buffer);
+					perform_move(vm_id, dest_server, buffer, cycle_breaker.PlanEviction(problem, dest_server, buffer, timer, duration));
 
-				if (iters == servers.size()) {
-					if (statmaker) {
-						statmaker->AddStat(stats);
+					if (servers[dest_server].CanFit(move_vm)) {
+						break;
 					}
-					return std::nullopt;
 				}
 			}
 
+			timer = std::max(timer, cycle_breaker.GroupEnd());
+
+			std::stable_sort(planned.begin(), planned.end(), [](const Movement& lhs, const Movement& rhs) {
+				return lhs.start_moment < rhs.start_moment;
+			});
+
+			if (available_for_migration.Empty()) {
+				if (statmaker) {
+					statmaker->AddStat(stats);
+				}
+				co_return false;
+			}
 		} else {
-			VM move_vm = *available_for_migration.begin();
-			available_for_migration.erase(available_for_migration.begin());
+			const VM& move_vm = problem.vms[available_for_migration.Front()];
+			available_for_migration.Erase(move_vm.id);
 
 			size_t from_server_id = vm_pos[move_vm.id];
 			size_t to_server_id = problem.end_position.vm_server[move_vm.id];
 
-			misplaced_vms.erase(move_vm);
-			perform_move(move_vm.id, from_server_id, to_server_id);
+			misplaced_vms.Erase(move_vm.id);
+			timer = perform_move(move_vm.id, from_server_id, to_server_id, timer);
 		}
+
+		for (const auto& move : planned) {
+			co_yield move;
+		}
+		planned.clear();
 	}
 
 	if (statmaker) {
 		statmaker->AddStat(stats);
 	}
-	return solution;
+	co_return true;
+}
+
+std::optional<Solution> Solve(const Problem& problem, AlgoStatMaker* statmaker, SolverWorkspace* workspace) {
+	SolverWorkspace local_workspace;
+	workspace = workspace ? workspace : &local_workspace;
+	return CollectPlan(Stream(problem, statmaker, workspace), problem.vms.size(), &workspace->Get<Scratch>().solution);
 }
 
 }
\ No newline at end of file
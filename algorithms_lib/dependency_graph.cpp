@@ -0,0 +1,453 @@
+#include "algorithms.h"
+
+#include <limits>
+
+#include <glog/logging.h>
+
+namespace AlgoDependencyGraph {
+
+constexpr size_t kUnvisited = std::numeric_limits<size_t>::max();
+constexpr size_t kExactEvictionCandidates = 10; // enumerate all eviction subsets up to this size
+
+size_t FindStronglyConnectedComponents(
+	const std::vector<std::vector<size_t>>& adj,
+	std::vector<size_t>* component
+) {
+	/*
+		Iterative Tarjan. Components are numbered in the order they are closed, which is
+		reverse topological order of the condensation: component 0 has no outgoing edges.
+	*/
+
+	size_t n = adj.size();
+
+	std::vector<size_t> index(n, kUnvisited);
+	std::vector<size_t> lowlink(n, 0);
+	std::vector<size_t> edge_ptr(n, 0);
+	std::vector<bool> on_stack(n, false);
+	std::vector<size_t> scc_stack;
+	std::vector<size_t> call_stack;
+
+	component->assign(n, kUnvisited);
+
+	size_t counter = 0;
+	size_t components = 0;
+
+	auto visit = [&](size_t v) {
+		index[v] = lowlink[v] = counter++;
+		scc_stack.push_back(v);
+		on_stack[v] = true;
+		call_stack.push_back(v);
+	};
+
+	for (size_t root = 0; root < n; ++root) {
+		if (index[root] != kUnvisited) {
+			continue;
+		}
+
+		visit(root);
+
+		while (!call_stack.empty()) {
+			size_t v = call_stack.back();
+
+			if (edge_ptr[v] < adj[v].size()) {
+				size_t to = adj[v][edge_ptr[v]++];
+
+				if (index[to] == kUnvisited) {
+					visit(to);
+				} else if (on_stack[to]) {
+					lowlink[v] = std::min(lowlink[v], index[to]);
+				}
+				continue;
+			}
+
+			call_stack.pop_back();
+
+			if (!call_stack.empty()) {
+				size_t parent = call_stack.back();
+				lowlink[parent] = std::min(lowlink[parent], lowlink[v]);
+			}
+
+			if (lowlink[v] == index[v]) {
+				while (true) {
+					size_t u = scc_stack.back();
+					scc_stack.pop_back();
+					on_stack[u] = false;
+					(*component)[u] = components;
+
+					if (u == v) {
+						break;
+					}
+				}
+				++components;
+			}
+		}
+	}
+
+	return components;
+}
+
+struct cmp_by_rank {
+	// largest VM first, ties go to destinations closer to the sinks of the condensation
+	const Problem* problem;
+	const std::vector<size_t>* dest_rank;
+
+	bool operator()(size_t lhs, size_t rhs) const {
+		if (problem->vms.Table().Mem(lhs) != problem->vms.Table().Mem(rhs)) {
+			return problem->vms.Table().Mem(lhs) > problem->vms.Table().Mem(rhs);
+		}
+		if ((*dest_rank)[lhs] != (*dest_rank)[rhs]) {
+			return (*dest_rank)[lhs] < (*dest_rank)[rhs];
+		}
+
+		return lhs < rhs;
+	}
+};
+
+struct Scratch {
+	SolveArena arena;
+	SolutionBuilder solution;
+	std::vector<size_t> vm_pos;
+	std::vector<Server> servers;
+	std::vector<Server> servers_end_pos;
+	std::vector<size_t> dest_rank; // topological rank of VM's destination
+	std::pmr::set<size_t, cmp_by_rank> available_for_migration{arena.Resource()};
+	std::vector<bool> misplaced;
+	std::vector<std::vector<size_t>> blocked_by;
+	std::vector<size_t> component;
+	std::vector<bool> in_cycle;
+};
+
+std::optional<Solution> SolveImpl(const Problem& problem, AlgoStatMaker* statmaker, SolverWorkspace* workspace) {
+	/*
+		Servers form a "blocked-by" graph: misplaced VM on server `s` heading to server `d`
+		gives an edge s -> d, and that move waits until `d` sends something away.
+		1) Condense the graph with Tarjan SCC. Available moves are taken greedily (largest VM first),
+			ties go to destinations closer to the sinks of the condensation (topological order).
+		2) If no move is possible, every sink of the condensation is a cycle (a server without
+			outgoing moves can always accept its incoming VMs). For each sink SCC choose the cheapest
+			(by memory moved) set of evictions from one of its servers that lets one move of the
+			cycle start, and push these VMs to buffer servers outside of cycles. All sink SCCs are
+			broken in the same round.
+	*/
+
+	AlgoStat stats;
+
+	size_t servers_cnt = problem.server_specs.size();
+
+	SolverWorkspace local_workspace;
+	Scratch& scratch = (workspace ? workspace : &local_workspace)->Get<Scratch>();
+
+	TimeMoment timer = 0;
+	SolutionBuilder& solution = scratch.solution;
+	solution.Reset(problem.vms.size());
+
+	std::vector<size_t>& vm_pos = scratch.vm_pos;
+	vm_pos.assign(problem.start_position.vm_server.begin(), problem.start_position.vm_server.end());
+
+	std::vector<Server>& servers = scratch.servers;
+	std::vector<Server>& servers_end_pos = scratch.servers_end_pos;
+	ResetServers(&servers, problem.server_specs, scratch.arena.Resource());
+	ResetServers(&servers_end_pos, problem.server_specs, scratch.arena.Resource());
+
+	// ranks are only rewritten while the set is empty, so ordering stays consistent
+	std::pmr::set<size_t, cmp_by_rank>& available_for_migration = scratch.available_for_migration;
+	available_for_migration = std::pmr::set<size_t, cmp_by_rank>(cmp_by_rank{&problem, &scratch.dest_rank}, scratch.arena.Resource());
+	scratch.arena.Reset();
+
+	for (const auto& vm : problem.vms) {
+		servers[vm_pos[vm.id]].ReceiveVM(vm);
+		servers[vm_pos[vm.id]].CancelReceivingVM(vm);
+
+		servers_end_pos[problem.end_position.vm_server[vm.id]].ReceiveVM(vm);
+		servers_end_pos[problem.end_position.vm_server[vm.id]].CancelReceivingVM(vm);
+	}
+
+	std::vector<size_t>& dest_rank = scratch.dest_rank;
+	dest_rank.assign(problem.vms.size(), 0);
+
+	std::vector<bool>& misplaced = scratch.misplaced;
+	misplaced.assign(problem.vms.size(), false);
+	size_t misplaced_cnt = 0;
+
+	for (const auto& vm : problem.vms) {
+		size_t end_pos = problem.end_position.vm_server[vm.id];
+
+		if (end_pos != vm_pos[vm.id]) {
+			misplaced[vm.id] = true;
+			++misplaced_cnt;
+		}
+	}
+
+	auto perform_move = [&](size_t vm_id, size_t from, size_t to) {
+		vm_pos[vm_id] = to;
+
+		if (from == to) {
+			return;
+		}
+
+		++stats.totalMigrations;
+
+		servers[from].SendVM(problem.vms[vm_id]);
+		servers[to].ReceiveVM(problem.vms[vm_id]);
+		servers[from].CancelSendingVM(problem.vms[vm_id]);
+		servers[to].CancelReceivingVM(problem.vms[vm_id]);
+
+		TimeMoment duration = MigrationDuration(problem, vm_id, from, to);
+		solution.AddMovement(vm_id, from, to, timer, duration);
+
+		timer += duration;
+
+		// recalculate available_for_migration
+
+		for (auto vm_id : *servers_end_pos[from].GetRawVMSet()) {
+			if (misplaced[vm_id] && servers[from].CanFit(problem.vms[vm_id])) {
+				available_for_migration.insert(vm_id);
+			}
+		}
+
+		for (auto vm_id : *servers_end_pos[to].GetRawVMSet()) {
+			if (!servers[to].CanFit(problem.vms[vm_id])) {
+				available_for_migration.erase(vm_id);
+			}
+		}
+	};
+
+	std::vector<std::vector<size_t>>& blocked_by = scratch.blocked_by;
+	blocked_by.resize(servers_cnt);
+	std::vector<size_t>& component = scratch.component;
+
+	// returns quantity of components, fills `component` and `dest_rank`
+	auto condense = [&]() -> size_t {
+		for (auto& adj : blocked_by) {
+			adj.clear();
+		}
+
+		for (size_t i = 0; i < problem.vms.size(); ++i) {
+			if (misplaced[i]) {
+				blocked_by[vm_pos[i]].push_back(problem.end_position.vm_server[i]);
+			}
+		}
+
+		size_t components = FindStronglyConnectedComponents(blocked_by, &component);
+
+		for (size_t i = 0; i < problem.vms.size(); ++i) {
+			dest_rank[i] = component[problem.end_position.vm_server[i]];
+		}
+
+		return components;
+	};
+
+	struct EvictionPlan {
+		size_t server = kUnvisited;
+		size_t cost = std::numeric_limits<size_t>::max();
+		std::vector<size_t> vms;
+	};
+
+	// cheapest subset of `candidates` (sorted by memory) freeing at least `need_cpu` and `need_mem`
+	auto choose_evictions = [&](
+		const std::vector<size_t>& candidates,
+		size_t need_cpu,
+		size_t need_mem,
+		EvictionPlan* best,
+		size_t server
+	) {
+		if (candidates.size() <= kExactEvictionCandidates) {
+			for (size_t mask = 1; mask < (size_t{1} << candidates.size()); ++mask) {
+				size_t cpu = 0, mem = 0;
+
+				for (size_t i = 0; i < candidates.size(); ++i) {
+					if (mask >> i & 1) {
+						cpu += problem.vms[candidates[i]].cpu;
+						mem += problem.vms[candidates[i]].mem;
+					}
+				}
+
+				if (cpu < need_cpu || mem < need_mem || mem >= best->cost) {
+					continue;
+				}
+
+				best->cost = mem;
+				best->server = server;
+				best->vms.clear();
+
+				for (size_t i = 0; i < candidates.size(); ++i) {
+					if (mask >> i & 1) {
+						best->vms.push_back(candidates[i]);
+					}
+				}
+			}
+			return;
+		}
+
+		size_t cpu = 0, mem = 0;
+		std::vector<size_t> taken;
+
+		for (auto vm_id : candidates) {
+			if (cpu >= need_cpu && mem >= need_mem) {
+				break;
+			}
+			cpu += problem.vms.Table().Cpu(vm_id);
+			mem += problem.vms.Table().Mem(vm_id);
+			taken.push_back(vm_id);
+		}
+
+		if (cpu >= need_cpu && mem >= need_mem && mem < best->cost) {
+			best->cost = mem;
+			best->server = server;
+			best->vms = std::move(taken);
+		}
+	};
+
+	std::vector<bool>& in_cycle = scratch.in_cycle;
+	in_cycle.assign(servers_cnt, false);
+	size_t ptr_servers = 0;
+
+	auto find_buffer = [&](size_t vm_id, size_t dest_server) -> std::optional<size_t> {
+		// prefer servers that do not take part in any cycle, so buffers do not block them
+		for (bool allow_cycles : {false, true}) {
+			for (size_t iters = 0; iters < servers_cnt; ++iters) {
+				size_t candidate = (ptr_servers + iters) % servers_cnt;
+
+				if (candidate == dest_server || (in_cycle[candidate] && !allow_cycles)) {
+					continue;
+				}
+
+				if (servers[candidate].CanFit(problem.vms[vm_id])) {
+					ptr_servers = candidate;
+					return candidate;
+				}
+			}
+		}
+
+		return std::nullopt;
+	};
+
+	auto break_cycles = [&]() -> bool {
+		size_t components = condense();
+
+		std::vector<size_t> component_size(components, 0);
+		std::vector<bool> has_outgoing(components, false);
+		std::vector<std::vector<size_t>> component_servers(components);
+
+		for (size_t i = 0; i < servers_cnt; ++i) {
+			++component_size[component[i]];
+			component_servers[component[i]].push_back(i);
+
+			for (auto to : blocked_by[i]) {
+				if (component[to] != component[i]) {
+					has_outgoing[component[i]] = true;
+				}
+			}
+		}
+
+		for (size_t i = 0; i < servers_cnt; ++i) {
+			in_cycle[i] = component_size[component[i]] > 1;
+		}
+
+		std::vector<std::vector<size_t>> incoming(servers_cnt);
+		for (size_t i = 0; i < problem.vms.size(); ++i) {
+			if (misplaced[i] && component[vm_pos[i]] == component[problem.end_position.vm_server[i]]) {
+				incoming[problem.end_position.vm_server[i]].push_back(i);
+			}
+		}
+
+		bool broken_any = false;
+
+		for (size_t c = 0; c < components; ++c) {
+			if (component_size[c] < 2 || has_outgoing[c]) {
+				continue;
+			}
+
+			EvictionPlan best;
+
+			for (auto dest_server : component_servers[c]) {
+				if (incoming[dest_server].empty()) {
+					continue;
+				}
+
+				std::vector<size_t> candidates;
+				for (auto vm_id : *servers[dest_server].GetRawVMSet()) {
+					if (misplaced[vm_id]) {
+						candidates.push_back(vm_id);
+					}
+				}
+
+				std::sort(candidates.begin(), candidates.end(), [&](size_t lhs, size_t rhs) {
+					if (problem.vms.Table().Mem(lhs) != problem.vms.Table().Mem(rhs)) {
+						return problem.vms.Table().Mem(lhs) < problem.vms.Table().Mem(rhs);
+					}
+					return lhs < rhs;
+				});
+
+				auto [free_cpu, free_mem] = servers[dest_server].GetFreeSpace();
+
+				for (auto vm_id : incoming[dest_server]) {
+					const VM& vm = problem.vms[vm_id];
+					size_t need_cpu = vm.cpu > free_cpu ? vm.cpu - free_cpu : 0;
+					size_t need_mem = vm.mem > free_mem ? vm.mem - free_mem : 0;
+
+					choose_evictions(candidates, need_cpu, need_mem, &best, dest_server);
+				}
+			}
+
+			if (best.server == kUnvisited) {
+				return false;
+			}
+
+			++stats.brokenCycles;
+
+			for (auto vm_id : best.vms) {
+				auto buffer = find_buffer(vm_id, best.server);
+
+				if (!buffer) {
+					return false;
+				}
+
+				++stats.migrationsBreakingCycles;
+				perform_move(vm_id, best.server, *buffer);
+			}
+
+			broken_any = true;
+		}
+
+		return broken_any;
+	};
+
+	condense();
+
+	for (size_t i = 0; i < problem.vms.size(); ++i) {
+		if (misplaced[i] && servers[problem.end_position.vm_server[i]].CanFit(problem.vms[i])) {
+			available_for_migration.insert(i);
+		}
+	}
+
+	while (misplaced_cnt) {
+		if (available_for_migration.empty()) {
+			if (!break_cycles() || available_for_migration.empty()) {
+				if (statmaker) {
+					statmaker->AddStat(stats);
+				}
+				return std::nullopt;
+			}
+			continue;
+		}
+
+		size_t vm_id = *available_for_migration.begin();
+		available_for_migration.erase(available_for_migration.begin());
+
+		misplaced[vm_id] = false;
+		--misplaced_cnt;
+		perform_move(vm_id, vm_pos[vm_id], problem.end_position.vm_server[vm_id]);
+	}
+
+	if (statmaker) {
+		statmaker->AddStat(stats);
+	}
+	return solution.Build();
+}
+
+std::optional<Solution> Solve(const Problem& problem, AlgoStatMaker* statmaker, SolverWorkspace* workspace) {
+	return Parallelizer::ParallelizeSolution(SolveImpl, problem, statmaker, workspace);
+}
+
+}
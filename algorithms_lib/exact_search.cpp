@@ -0,0 +1,407 @@
+#include "algorithms.h"
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include <glog/logging.h>
+
+namespace AlgoExact {
+
+constexpr size_t kMemoShards = 64;
+constexpr size_t kClockCheckPeriod = 1024; // nodes between time limit checks
+
+struct Node {
+	std::string positions; // local server of each VM, one byte per VM
+	double cost; // weight of moves made so far
+	std::vector<Movement> moves;
+};
+
+class SearchState {
+	/*
+		Everything shared by the workers of one search: the component, the incumbent,
+		the memo of visited placements and the per-worker deques.
+	*/
+public:
+	SearchState(const Problem& problem, std::span<const size_t> vm_pos, Objective objective, const SearchLimits& limits);
+
+	void Run();
+	SearchResult TakeResult();
+
+private:
+	void Worker(size_t worker_id);
+	bool PopTask(size_t worker_id, Node* node);
+	void PushTask(size_t worker_id, Node node);
+	void Expand(size_t worker_id, const Node& node);
+
+	bool Visit(const Node& node); // false if the placement was already reached at most as cheaply
+	double LowerBound(const Node& node) const;
+	double Weight(size_t vm, size_t from, size_t to) const; // cost of a move between local servers
+	bool OutOfLimits();
+
+private:
+	const Problem& problem_;
+	Objective objective_;
+	SearchLimits limits_;
+	std::chrono::steady_clock::time_point deadline_;
+
+	std::vector<size_t> vms_; // misplaced VMs, search works with their local indices
+	std::vector<size_t> servers_; // local server -> server id: endpoints of misplaced VMs, then buffers
+	std::vector<uint8_t> source_; // local VM -> local server at start
+	std::vector<size_t> by_weight_; // local VMs, heaviest first
+	std::vector<uint8_t> destination_; // local VM -> local server
+	std::vector<Resources> free_at_start_; // free resources of local servers before any move
+	std::vector<double> finish_cost_; // local VM -> cheapest way from its source to its destination
+	std::vector<double> park_cost_; // local VM -> cheapest way through a buffer, infinity if none
+
+	struct WorkerQueue {
+		std::mutex mutex;
+		std::deque<Node> tasks; // owner works at the back, thieves take from the front
+	};
+	std::vector<WorkerQueue> workers_;
+	std::atomic<size_t> pending_ = 0; // pushed and not yet expanded tasks
+
+	struct MemoShard {
+		std::mutex mutex;
+		std::unordered_map<std::string, double> best_cost;
+	};
+	std::vector<MemoShard> memo_;
+
+	std::mutex incumbent_mutex_;
+	std::atomic<double> best_cost_;
+	std::vector<Movement> best_moves_;
+	bool found_ = false;
+
+	std::atomic<size_t> nodes_ = 0;
+	std::atomic<bool> stopped_ = false;
+};
+
+SearchState::SearchState(const Problem& problem, std::span<const size_t> vm_pos, Objective objective, const SearchLimits& limits)
+	: problem_(problem)
+	, objective_(objective)
+	, limits_(limits)
+	, workers_(std::max<size_t>(limits.threads, 1))
+	, memo_(kMemoShards)
+	, best_cost_(std::numeric_limits<double>::infinity())
+{
+	size_t servers_cnt = problem.server_specs.size();
+	std::vector<size_t> local(servers_cnt, servers_cnt);
+
+	auto add_server = [&](size_t server_id) {
+		if (local[server_id] == servers_cnt) {
+			local[server_id] = servers_.size();
+			servers_.push_back(server_id);
+		}
+	};
+
+	for (const auto& vm : problem.vms) {
+		if (vm_pos[vm.id] != problem.end_position.vm_server[vm.id]) {
+			vms_.push_back(vm.id);
+			add_server(vm_pos[vm.id]);
+			add_server(problem.end_position.vm_server[vm.id]);
+		}
+	}
+
+	std::vector<Resources> free(servers_cnt);
+	for (size_t i = 0; i < servers_cnt; ++i) {
+		free[i] = Capacity(problem.server_specs[i]);
+	}
+	for (const auto& vm : problem.vms) {
+		free[vm_pos[vm.id]] -= Demand(vm);
+	}
+
+	// buffers: servers outside of the component with the most free memory
+	std::vector<size_t> outside;
+	for (size_t i = 0; i < servers_cnt; ++i) {
+		if (local[i] == servers_cnt) {
+			outside.push_back(i);
+		}
+	}
+	size_t buffers = std::min(limits.buffer_servers, outside.size());
+	std::partial_sort(outside.begin(), outside.begin() + buffers, outside.end(), [&](size_t lhs, size_t rhs) {
+		return free[lhs][kMem] > free[rhs][kMem];
+	});
+	for (size_t i = 0; i < buffers; ++i) {
+		add_server(outside[i]);
+	}
+
+	for (size_t vm : vms_) {
+		source_.push_back(local[vm_pos[vm]]);
+		destination_.push_back(local[problem.end_position.vm_server[vm]]);
+	}
+	for (size_t server_id : servers_) {
+		free_at_start_.push_back(free[server_id]);
+	}
+
+	for (size_t vm = 0; vm < vms_.size(); ++vm) {
+		double park = std::numeric_limits<double>::infinity();
+		for (size_t buffer = 0; buffer < servers_.size(); ++buffer) {
+			if (buffer != source_[vm] && buffer != destination_[vm]) {
+				park = std::min(park, Weight(vm, source_[vm], buffer) + Weight(vm, buffer, destination_[vm]));
+			}
+		}
+		park_cost_.push_back(park);
+		finish_cost_.push_back(std::min(park, Weight(vm, source_[vm], destination_[vm])));
+		by_weight_.push_back(vm);
+	}
+	std::stable_sort(by_weight_.begin(), by_weight_.end(), [&](size_t lhs, size_t rhs) {
+		return finish_cost_[lhs] > finish_cost_[rhs];
+	});
+
+	Node root;
+	root.positions.assign(source_.begin(), source_.end());
+	root.cost = 0;
+
+	PushTask(0, std::move(root));
+}
+
+double SearchState::Weight(size_t vm, size_t from, size_t to) const {
+	if (objective_ == Objective::kMemoryMoved) {
+		return problem_.vms.Table().Mem(vms_[vm]);
+	}
+	return MigrationDuration(problem_, vms_[vm], servers_[from], servers_[to]);
+}
+
+double SearchState::LowerBound(const Node& node) const {
+	// every VM away from its destination still gets there: a parked one directly, one at
+	// its source at least along its cheapest route
+	double bound = node.cost;
+	for (size_t vm = 0; vm < vms_.size(); ++vm) {
+		uint8_t at = node.positions[vm];
+
+		if (at == source_[vm]) {
+			bound += finish_cost_[vm];
+		} else if (at != destination_[vm]) {
+			bound += Weight(vm, at, destination_[vm]);
+		}
+	}
+	return bound;
+}
+
+bool SearchState::Visit(const Node& node) {
+	MemoShard& shard = memo_[std::hash<std::string>()(node.positions) % kMemoShards];
+	std::lock_guard lock(shard.mutex);
+
+	auto [it, inserted] = shard.best_cost.try_emplace(node.positions, node.cost);
+	if (!inserted) {
+		if (it->second <= node.cost) {
+			return false;
+		}
+		it->second = node.cost;
+	}
+	return true;
+}
+
+bool SearchState::OutOfLimits() {
+	size_t nodes = ++nodes_;
+
+	if (nodes > limits_.max_nodes) {
+		stopped_ = true;
+	} else if (limits_.time_limit != std::chrono::milliseconds::zero()
+			&& nodes % kClockCheckPeriod == 0 && std::chrono::steady_clock::now() > deadline_) {
+		stopped_ = true;
+	}
+	return stopped_;
+}
+
+void SearchState::PushTask(size_t worker_id, Node node) {
+	++pending_;
+	std::lock_guard lock(workers_[worker_id].mutex);
+	workers_[worker_id].tasks.push_back(std::move(node));
+}
+
+bool SearchState::PopTask(size_t worker_id, Node* node) {
+	{
+		std::lock_guard lock(workers_[worker_id].mutex);
+		auto& tasks = workers_[worker_id].tasks;
+
+		if (!tasks.empty()) {
+			*node = std::move(tasks.back());
+			tasks.pop_back();
+			return true;
+		}
+	}
+
+	// steal the oldest task, it is the root of the largest unexplored subtree
+	for (size_t shift = 1; shift < workers_.size(); ++shift) {
+		WorkerQueue& victim = workers_[(worker_id + shift) % workers_.size()];
+		std::lock_guard lock(victim.mutex);
+
+		if (!victim.tasks.empty()) {
+			*node = std::move(victim.tasks.front());
+			victim.tasks.pop_front();
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void SearchState::Expand(size_t worker_id, const Node& node) {
+	if (LowerBound(node) >= best_cost_ || !Visit(node)) {
+		return;
+	}
+
+	// free space of local servers in this placement
+	std::vector<Resources> free = free_at_start_;
+	for (size_t vm = 0; vm < vms_.size(); ++vm) {
+		uint8_t now = node.positions[vm];
+
+		if (now != source_[vm]) {
+			Resources demand = Demand(problem_.vms[vms_[vm]]);
+			free[now] -= demand;
+			free[source_[vm]] += demand;
+		}
+	}
+
+	bool finished = true;
+	for (size_t vm = 0; vm < vms_.size(); ++vm) {
+		finished &= static_cast<uint8_t>(node.positions[vm]) == destination_[vm];
+	}
+
+	if (finished) {
+		std::lock_guard lock(incumbent_mutex_);
+		if (node.cost < best_cost_) {
+			best_cost_ = node.cost;
+			best_moves_ = node.moves;
+			found_ = true;
+		}
+		return;
+	}
+
+	// no VM fits into its destination: at least one more VM has to be parked, which costs
+	// the bound the difference between its route through a buffer and its cheapest one
+	bool stuck = true;
+	double cheapest_park = std::numeric_limits<double>::infinity();
+	for (size_t vm = 0; vm < vms_.size(); ++vm) {
+		uint8_t at = node.positions[vm];
+		if (at == destination_[vm]) {
+			continue;
+		}
+
+		stuck &= !Demand(problem_.vms[vms_[vm]]).FitsInto(free[destination_[vm]]);
+		if (at == source_[vm]) {
+			cheapest_park = std::min(cheapest_park, park_cost_[vm] - finish_cost_[vm]);
+		}
+	}
+
+	if (stuck && LowerBound(node) + cheapest_park >= best_cost_) {
+		return;
+	}
+
+	auto child = [&](size_t vm, uint8_t to) {
+		Node next = node;
+		size_t from = static_cast<uint8_t>(node.positions[vm]);
+		TimeMoment start = node.moves.empty() ? 0 : node.moves.back().start_moment + node.moves.back().duration;
+
+		next.positions[vm] = to;
+		next.cost += Weight(vm, from, to);
+		next.moves.push_back(Movement{
+			static_cast<uint32_t>(servers_[from]),
+			static_cast<uint32_t>(servers_[to]),
+			static_cast<uint32_t>(vms_[vm]),
+			start,
+			MigrationDuration(problem_, vms_[vm], servers_[from], servers_[to])
+		});
+
+		if (LowerBound(next) < best_cost_) {
+			PushTask(worker_id, std::move(next));
+		}
+	};
+
+	// pushed last is explored first: direct moves to destinations go on top, then parking of the cheapest VMs
+	for (size_t vm : by_weight_) {
+		if (static_cast<uint8_t>(node.positions[vm]) != source_[vm]) {
+			continue; // a VM is parked at most once and never leaves its destination
+		}
+
+		Resources demand = Demand(problem_.vms[vms_[vm]]);
+		for (size_t to = 0; to < servers_.size(); ++to) {
+			if (to != source_[vm] && to != destination_[vm] && demand.FitsInto(free[to])) {
+				child(vm, to);
+			}
+		}
+	}
+
+	for (size_t vm = 0; vm < vms_.size(); ++vm) {
+		uint8_t at = node.positions[vm];
+		if (at != destination_[vm] && Demand(problem_.vms[vms_[vm]]).FitsInto(free[destination_[vm]])) {
+			child(vm, destination_[vm]);
+		}
+	}
+}
+
+void SearchState::Worker(size_t worker_id) {
+	Node node;
+
+	while (pending_ > 0 && !stopped_) {
+		if (!PopTask(worker_id, &node)) {
+			std::this_thread::yield();
+			continue;
+		}
+
+		if (!OutOfLimits()) {
+			Expand(worker_id, node);
+		}
+		--pending_;
+	}
+}
+
+void SearchState::Run() {
+	deadline_ = std::chrono::steady_clock::now() + limits_.time_limit;
+
+	if (vms_.empty()) {
+		found_ = true;
+		best_cost_ = 0;
+		return;
+	}
+
+	if (vms_.size() > kMaxSearchVMs || servers_.size() > UINT8_MAX) {
+		stopped_ = true;
+		return;
+	}
+
+	std::vector<std::thread> threads;
+	for (size_t i = 1; i < workers_.size(); ++i) {
+		threads.emplace_back([this, i]() { Worker(i); });
+	}
+	Worker(0);
+
+	for (auto& thread : threads) {
+		thread.join();
+	}
+}
+
+SearchResult SearchState::TakeResult() {
+	SearchResult result;
+	result.found = found_;
+	result.optimal = found_ && !stopped_;
+	result.cost = found_ ? best_cost_.load() : 0;
+	result.nodes = nodes_;
+	result.moves = std::move(best_moves_);
+	return result;
+}
+
+SearchResult SearchSchedule(
+	const Problem& problem, std::span<const size_t> vm_pos, Objective objective, const SearchLimits& limits
+) {
+	/*
+		Branch and bound over sequences of moves of the misplaced VMs. A move sends a VM to its
+		destination or parks it on a buffer (a server of the component or one of a few emptiest
+		servers outside of it); a VM is parked at most once and stays on its destination. A move
+		costs the memory of the VM or its migration duration over the hop. Bound: cost so far plus
+		the cheapest remaining route of every VM away from its destination. Placements already reached at most as
+		cheaply are pruned. Workers keep subtrees in their own deques (depth-first from the back)
+		and steal the oldest task of another worker when idle.
+	*/
+
+	SearchState state(problem, vm_pos, objective, limits);
+	state.Run();
+	return state.TakeResult();
+}
+
+}
@@ -1,18 +1,11 @@
 #include "algorithms.h"
 
+#include <cmath>
+
 #include <glog/logging.h>
 
 namespace AlgoFlowGrouping {
 
-struct cmp_by_mem {
-	bool operator()(const VM& lhs, const VM& rhs) const {
-		if (lhs.mem != rhs.mem) {
-			return lhs.mem > rhs.mem;
-		}
-		return lhs.id < rhs.id;
-	}
-};
-
 constexpr size_t kMaximumLayers = 1e9;
 constexpr size_t kMaximumFlow = 1e9;
 
@@ -22,6 +15,7 @@ struct Edge {
 	size_t capacity;
 	size_t id;
 	bool rev;
+	int64_t cost = 0; // reverse edge has the negated cost
 };
 
 struct Graph {
@@ -31,17 +25,31 @@ struct Graph {
 };
 
 struct FlowState {
-	Graph g;
+	const Graph* g = nullptr;
 	std::vector<size_t> flow; // array with flow values for each edge
 	size_t totalFlow = 0;
 
-	FlowState(const Graph& g_new) : g(g_new) {
+	// buffers of Dinic iterations, kept between calls
+	std::vector<size_t> distances;
+	std::vector<size_t> adjPtrs;
+	std::vector<size_t> bfsQueue;
+
+	// buffers of min-cost flow
+	std::vector<int64_t> potentials;
+	std::vector<int64_t> costDistances;
+	std::vector<const Edge*> parentEdges;
+	std::vector<std::pair<int64_t, size_t>> heap;
+
+	void Reset(const Graph& g_new) {
+		g = &g_new;
+		totalFlow = 0;
+
 		size_t edges_count = 0;
-		for (size_t i = 0; i < g.adjLists.size(); ++i) {
-			edges_count += g.adjLists[i].size();
+		for (size_t i = 0; i < g->adjLists.size(); ++i) {
+			edges_count += g->adjLists[i].size();
 		}
 
-		flow.resize(edges_count / 2, 0); // each edge is counted twice (as straight and reverse)
+		flow.assign(edges_count / 2, 0); // each edge is counted twice (as straight and reverse)
 	}
 
 	size_t GetResidualThroughput(const Edge& edge) const {
@@ -57,12 +65,12 @@ size_t FindBlockingFlow(
 	const std::vector<size_t>& distances
 ) 
 {
-	if (v == flowState.g.drain) {
+	if (v == flowState.g->drain) {
 		return flow;
 	}
 
-	while (adjPtrs[v] < flowState.g.adjLists[v].size()) {
-		auto e = flowState.g.adjLists[v][adjPtrs[v]++];
+	while (adjPtrs[v] < flowState.g->adjLists[v].size()) {
+		auto e = flowState.g->adjLists[v][adjPtrs[v]++];
 		size_t canPush = flowState.GetResidualThroughput(e);
 
 		if (canPush && distances[e.to] == distances[v] + 1) {
@@ -92,31 +100,32 @@ size_t DinicIteration(FlowState& flowState) {
 		2) Find blocking flow through layered network and change residual network
 	*/
 
-	auto& g = flowState.g;
+	const auto& g = *flowState.g;
 
 	// 1---------------------------------------------------
 
-	std::vector<size_t> distances(g.adjLists.size(), kMaximumLayers);
+	std::vector<size_t>& distances = flowState.distances;
+	distances.assign(g.adjLists.size(), kMaximumLayers);
 	distances[g.sink] = 0;
-	std::queue<size_t> bfsQueue;
-	bfsQueue.push(g.sink);
+	std::vector<size_t>& bfsQueue = flowState.bfsQueue;
+	bfsQueue.assign(1, g.sink);
 
-	while (!bfsQueue.empty()) {
-		auto curv = bfsQueue.front();
-		bfsQueue.pop();
+	for (size_t head = 0; head < bfsQueue.size(); ++head) {
+		auto curv = bfsQueue[head];
 
 		for (const auto& e : g.adjLists[curv]) {
 			if (flowState.GetResidualThroughput(e) &&
 				distances[e.to] > distances[curv] + 1) {
 				distances[e.to] = distances[curv] + 1;
-				bfsQueue.push(e.to);
+				bfsQueue.push_back(e.to);
 			}
 		}
 	}
 
 	// 2----------------------------------------------------
 
-	std::vector<size_t> adjPtrs(g.adjLists.size());
+	std::vector<size_t>& adjPtrs = flowState.adjPtrs;
+	adjPtrs.assign(g.adjLists.size(), 0);
 
 	size_t pushedTotal = 0;
 	while (size_t pushed = FindBlockingFlow(g.sink, flowState, kMaximumFlow, adjPtrs, distances)) {
@@ -132,59 +141,270 @@ size_t DinicIteration(FlowState& flowState) {
 	return pushedTotal;
 }
 
-FlowState DinicFindMaxFlow(const Graph& g) {
-	FlowState flowState(g);
-	while (DinicIteration(flowState)) {}
-	return flowState;
+void DinicFindMaxFlow(const Graph& g, FlowState* flowState) {
+	flowState->Reset(g);
+	while (DinicIteration(*flowState)) {}
 }
+
+constexpr int64_t kInfiniteCost = INT64_MAX / 4;
+
+void MinCostMaxFlow(const Graph& g, FlowState* flowState) {
+	/*
+		Successive shortest paths with Dijkstra on reduced costs (Johnson potentials), so the
+		result is a maximum flow of minimal cost. Edge costs may be negative: the graph
+		sink -> server outputs -> server inputs -> drain is layered, so initial potentials are
+		shortest distances computed layer by layer.
+	*/
+
+	flowState->Reset(g);
+
+	size_t nodes = g.adjLists.size();
+	std::vector<int64_t>& potentials = flowState->potentials;
+	potentials.assign(nodes, kInfiniteCost);
+	potentials[g.sink] = 0;
+
+	// sink edges have zero cost, then relax output -> input, then input -> drain
+	for (const auto& e : g.adjLists[g.sink]) {
+		potentials[e.to] = 0;
+	}
+	for (size_t layer = 0; layer < 2; ++layer) {
+		for (size_t v = 0; v < nodes; ++v) {
+			if (potentials[v] == kInfiniteCost || v == g.sink) {
+				continue;
+			}
+			for (const auto& e : g.adjLists[v]) {
+				if (!e.rev && e.to != g.sink) {
+					potentials[e.to] = std::min(potentials[e.to], potentials[v] + e.cost);
+				}
+			}
+		}
+	}
+	for (auto& potential : potentials) {
+		if (potential == kInfiniteCost) {
+			potential = 0; // unreachable, never relaxed
+		}
+	}
+
+	std::vector<int64_t>& dist = flowState->costDistances;
+	std::vector<const Edge*>& parent = flowState->parentEdges;
+	auto& heap = flowState->heap;
+	auto heap_cmp = std::greater<std::pair<int64_t, size_t>>();
+
+	while (true) {
+		dist.assign(nodes, kInfiniteCost);
+		parent.assign(nodes, nullptr);
+		dist[g.sink] = 0;
+		heap.assign(1, {0, g.sink});
+
+		while (!heap.empty()) {
+			std::pop_heap(heap.begin(), heap.end(), heap_cmp);
+			auto [d, v] = heap.back();
+			heap.pop_back();
+
+			if (d != dist[v]) {
+				continue;
+			}
+			if (v == g.drain) {
+				break; // the rest of the nodes are not closer than drain
+			}
+
+			for (const auto& e : g.adjLists[v]) {
+				if (!flowState->GetResidualThroughput(e)) {
+					continue;
+				}
+
+				int64_t reduced = d + e.cost + potentials[v] - potentials[e.to];
+				if (reduced < dist[e.to]) {
+					dist[e.to] = reduced;
+					parent[e.to] = &e;
+					heap.push_back({reduced, e.to});
+					std::push_heap(heap.begin(), heap.end(), heap_cmp);
+				}
+			}
+		}
+
+		if (dist[g.drain] == kInfiniteCost) {
+			break;
+		}
+
+		// capping by the drain distance keeps reduced costs non-negative after the early exit
+		for (size_t v = 0; v < nodes; ++v) {
+			potentials[v] += std::min(dist[v], dist[g.drain]);
+		}
+
+		size_t pushed = kMaximumFlow;
+		for (size_t v = g.drain; v != g.sink; v = parent[v]->from) {
+			pushed = std::min(pushed, flowState->GetResidualThroughput(*parent[v]));
+		}
+
+		for (size_t v = g.drain; v != g.sink; v = parent[v]->from) {
+			const Edge& e = *parent[v];
+			if (e.rev) {
+				flowState->flow[e.id] -= pushed;
+			} else {
+				flowState->flow[e.id] += pushed;
+			}
+		}
+
+		flowState->totalFlow += pushed;
+	}
+}
+
+struct Scratch {
+	SolveArena arena;
+	SolutionBuilder solution;
+	std::vector<Server> servers;
+	FitIndex fit_index;
+	MemoryBucketQueue available_for_migration;
+	MemoryBucketQueue misplaced_vms;
+	std::vector<size_t> vm_pos;
+	std::vector<size_t> edge_vm_bijection;
+	CycleBreaker cycle_breaker;
+	std::vector<size_t> targets;
+	std::vector<size_t> vm_sorted_by_mem;
+	std::vector<Movement> group; // evictions or a round, not emitted yet
+	std::vector<TimeMoment> server_load; // remaining migration time from and to each server
+	Graph graph;
+	FlowState flow;
+};
   
-std::optional<Solution> SolveImpl(const Problem& problem, AlgoStatMaker* statmaker) {
+enum class Grouping {
+	kMaxFlow, // any maximum flow
+	kMinCost, // maximum flow of minimal cost: long migrations and loaded servers first
+	kWeightedCompletion // maximum flow of minimal cost: VMs close to deadlines, then high priority per time
+};
+
+constexpr long double kMigrationTimeWeight = 1;
+constexpr long double kServerLoadWeight = 1;
+constexpr long double kCostScale = 1e6;
+constexpr size_t kExactSearchThreshold = 10; // misplaced VMs
+
+// more negative is more urgent: long migration between servers with much remaining work
+int64_t UrgencyCost(TimeMoment migration_time, TimeMoment route_load, TimeMoment max_time, TimeMoment max_load) {
+	long double urgency =
+		kMigrationTimeWeight * migration_time / max_time +
+		kServerLoadWeight * route_load / (2 * max_load);
+
+	return -std::llround(kCostScale * urgency);
+}
+
+/*
+	Buffer for a VM evicted from `from` which then goes on to `to`, not one of `excluded` (bit per
+	server). On a flat network it is the first host in cyclic order from `start`, otherwise the
+	host with the cheapest pair of hops, so cycles are broken inside racks and pods when they have room.
+*/
+size_t FindBuffer(
+	const Problem& problem,
+	const std::vector<Server>& servers,
+	FitIndex& fit_index,
+	size_t vm_id,
+	size_t from,
+	size_t to,
+	size_t start,
+	const std::vector<uint64_t>& excluded
+) {
+	const VM& vm = problem.vms[vm_id];
+	if (problem.topology.Empty()) {
+		return fit_index.FindHost(vm, start, from, excluded);
+	}
+
+	const Topology& topology = problem.topology;
+	size_t best = FitIndex::kNone;
+	double best_cost = 0;
+
+	for (size_t server = 0; server < servers.size(); ++server) {
+		bool skip = server / 64 < excluded.size() && (excluded[server / 64] >> (server % 64) & 1);
+		if (skip || server == from || !servers[server].CanFit(vm)) {
+			continue;
+		}
+
+		double cost = topology.hop_multiplier[topology.Hop(from, server)] + topology.hop_multiplier[topology.Hop(server, to)];
+		if (best == FitIndex::kNone || cost < best_cost) {
+			best = server;
+			best_cost = cost;
+		}
+	}
+
+	return best;
+}
+
+constexpr long double kDeadlineWeight = 4; // a VM about to miss its deadline goes before any other one
+
+/*
+	More negative is more urgent. Heavy short moves first (Smith's rule minimizes the weighted
+	sum of completion times of a single channel), VMs whose deadline slack is small compared
+	to the remaining work of the busiest server before everything else.
+*/
+int64_t CompletionCost(const VM& vm, TimeMoment duration, TimeMoment now, long double max_ratio, TimeMoment max_load) {
+	long double ratio = vm.priority / (duration > 0 ? duration : 1);
+	long double urgency = ratio / max_ratio;
+
+	if (vm.deadline != kNoDeadline) {
+		long double slack = static_cast<long double>(vm.deadline) - now - duration;
+		urgency += kDeadlineWeight * (slack <= 0 ? 1 : std::max<long double>(0, 1 - slack / max_load));
+	}
+
+	return -std::llround(kCostScale * urgency);
+}
+
+PlanStream StreamImpl(
+	const Problem& problem,
+	AlgoStatMaker* statmaker,
+	SolverWorkspace* workspace,
+	Grouping grouping
+) {
 	// ONLY WORKS IF ALL servers' `max_in` ARE 1
 	/*
 		1) Build bipartite graph, where each server is respresented as two vertices in different parts.
 			These two vertices mean input and output of server. Draw edges which represent possible VM migrations
 			(from output of source to input of destination, if there is enough space on destination server).
 		2) Extract concurrent migration groups as maximum flow in this bipartite graph. If no VM can move
-			to their destination -  create a couple of migration groups to break the cycle (like in baseline algorithm).
+			to their destination - break all disjoint cycles with one parallel group of evictions (like in baseline algorithm).
 		3) Try to combine groups - if finished migration in i-th group - try to start any possible migration 
 			in (i + 1)-th group, do not wait for whole i-th group.
+		Groups come out in order of their start moments, a group of evictions sorted by start, so
+		the parallelizer of step 3 can consume the plan while it is being built.
 	*/
 
 	size_t servers_cnt = problem.server_specs.size();
 
-	std::vector<Server> servers;
-	std::vector<Server> servers_end_pos;
-	servers.reserve(servers_cnt);
-	servers_end_pos.reserve(servers_cnt);
+	SolverWorkspace local_workspace;
+	Scratch& scratch = (workspace ? workspace : &local_workspace)->Get<Scratch>();
 
-	for (size_t i = 0; i < servers_cnt; ++i) {
-		servers.emplace_back(problem.server_specs[i], i);
-		servers_end_pos.emplace_back(problem.server_specs[i], i);
-	}
+	std::vector<Server>& servers = scratch.servers;
+	ResetServers(&servers, problem.server_specs, scratch.arena.Resource());
+
+	MemoryBucketQueue& available_for_migration = scratch.available_for_migration;
+	MemoryBucketQueue& misplaced_vms = scratch.misplaced_vms;
+	available_for_migration.Reset(problem.vms.Table());
+	misplaced_vms.Reset(available_for_migration);
+	scratch.arena.Reset();
 
 	for (size_t i = 0; i < problem.vms.size(); ++i) {
 		servers[problem.start_position.vm_server[i]].ReceiveVM(problem.vms[i]);
 		servers[problem.start_position.vm_server[i]].CancelReceivingVM(problem.vms[i]);
-
-		servers_end_pos[problem.end_position.vm_server[i]].ReceiveVM(problem.vms[i]);
-		servers_end_pos[problem.end_position.vm_server[i]].CancelReceivingVM(problem.vms[i]);
 	}
 
-	std::set<VM, cmp_by_mem> available_for_migration;
-	std::set<VM, cmp_by_mem> misplaced_vms;
-	std::vector<size_t> vm_pos = problem.start_position.vm_server;
+	FitIndex& fit_index = scratch.fit_index;
+	fit_index.Reset(problem, servers);
+
+	std::vector<size_t>& vm_pos = scratch.vm_pos;
+	vm_pos.assign(problem.start_position.vm_server.begin(), problem.start_position.vm_server.end());
 
 	auto recalculate = [&]() {
-		available_for_migration.clear();
-		misplaced_vms.clear();
-
-		for (size_t i = 0; i < problem.vms.size(); ++i) {
-			if (problem.end_position.vm_server[i] != vm_pos[i]) {
-				misplaced_vms.insert(problem.vms[i]);
-				if (servers[problem.end_position.vm_server[i]].CanFit(problem.vms[i])) {
-					available_for_migration.insert(problem.vms[i]);
+		available_for_migration.Clear();
+		misplaced_vms.Clear();
+
+		for (size_t server_id = 0; server_id < servers_cnt; ++server_id) {
+			fit_index.ForEachIncoming(server_id, [&](size_t vm_id, bool fits) {
+				if (vm_pos[vm_id] != server_id) {
+					misplaced_vms.Insert(vm_id);
+
+					if (fits) {
+						available_for_migration.Insert(vm_id);
+					}
 				}
-			}
+			});
 		}
 	};
 
@@ -199,42 +419,74 @@ std::optional<Solution> SolveImpl(const Problem& problem, AlgoStatMaker* statmak
 		servers[to].ReceiveVM(problem.vms[vm_id]);
 		servers[from].CancelSendingVM(problem.vms[vm_id]);
 		servers[to].CancelReceivingVM(problem.vms[vm_id]);
+		fit_index.UpdateServer(from);
+		fit_index.UpdateServer(to);
 
-		for (auto vm_id : *servers_end_pos[from].GetRawVMSet()) {
-			if (
-				servers[from].CanFit(problem.vms[vm_id]) &&
-				misplaced_vms.contains(problem.vms[vm_id])
-			) {
-				available_for_migration.insert(problem.vms[vm_id]);
+		fit_index.ForEachIncoming(from, [&](size_t vm_id, bool fits) {
+			if (fits && misplaced_vms.Contains(vm_id)) {
+				available_for_migration.Insert(vm_id);
 			}
-		}
+		});
 
-		for (auto vm_id : *servers_end_pos[to].GetRawVMSet()) {
-			if (
-				available_for_migration.contains(problem.vms[vm_id]) &&
-				!servers[to].CanFit(problem.vms[vm_id])
-			) {
-				available_for_migration.erase(problem.vms[vm_id]);
+		fit_index.ForEachIncoming(to, [&](size_t vm_id, bool fits) {
+			if (!fits) {
+				available_for_migration.Erase(vm_id);
 			}
+		});
+	};
+
+	std::vector<size_t>& edge_vm_bijection = scratch.edge_vm_bijection;
+
+	std::vector<TimeMoment>& server_load = scratch.server_load;
+
+	// of the direct move from the current position
+	auto remaining_time = [&](size_t vm_id) {
+		return MigrationDuration(problem, vm_id, vm_pos[vm_id], problem.end_position.vm_server[vm_id]);
+	};
+
+	auto count_server_load = [&]() {
+		server_load.assign(servers_cnt, 0);
+
+		for (size_t vm_id : misplaced_vms) {
+			server_load[vm_pos[vm_id]] += remaining_time(vm_id);
+			server_load[problem.end_position.vm_server[vm_id]] += remaining_time(vm_id);
 		}
 	};
 
-	std::vector<size_t> edge_vm_bijection;
+	auto migration_cost = [&](size_t vm_id, TimeMoment max_time, TimeMoment max_load) -> int64_t {
+		size_t from = vm_pos[vm_id], to = problem.end_position.vm_server[vm_id];
+		return UrgencyCost(remaining_time(vm_id), server_load[from] + server_load[to], max_time, max_load);
+	};
 
-	auto build_graph = [&]() {
-		Graph g;
+	auto build_graph = [&](Graph& g) {
 		g.adjLists.resize(2 * servers_cnt + 2);
+		for (auto& adj : g.adjLists) {
+			adj.clear();
+		}
 		g.sink = 2 * servers_cnt;
 		g.drain = 2 * servers_cnt + 1;
 		size_t edges_count = 0;
 		edge_vm_bijection.clear();
 
-		for (const auto& vm : available_for_migration) {
-			size_t from = vm_pos[vm.id], to = servers_cnt + problem.end_position.vm_server[vm.id];
-			g.adjLists[from].push_back(Edge{from, to, 1, edges_count, false});
-			g.adjLists[to].push_back(Edge{to, from, 1, edges_count++, true});
+		TimeMoment max_time = 0, max_load = 0;
+		if (grouping == Grouping::kMinCost) {
+			count_server_load();
+
+			for (size_t vm_id : available_for_migration) {
+				max_time = std::max(max_time, remaining_time(vm_id));
+			}
+			max_load = *std::max_element(server_load.begin(), server_load.end());
+		}
+		max_time = max_time > 0 ? max_time : 1;
+		max_load = max_load > 0 ? max_load : 1;
+
+		for (size_t vm_id : available_for_migration) {
+			size_t from = vm_pos[vm_id], to = servers_cnt + problem.end_position.vm_server[vm_id];
+			int64_t cost = grouping == Grouping::kMinCost ? migration_cost(vm_id, max_time, max_load) : 0;
+			g.adjLists[from].push_back(Edge{from, to, 1, edges_count, false, cost});
+			g.adjLists[to].push_back(Edge{to, from, 1, edges_count++, true, -cost});
 
-			edge_vm_bijection.push_back(vm.id);
+			edge_vm_bijection.push_back(vm_id);
 		}
 
 		for (size_t i = 0; i < servers_cnt; ++i) {
@@ -252,115 +504,732 @@ std::optional<Solution> SolveImpl(const Problem& problem, AlgoStatMaker* statmak
 				Edge{g.drain, servers_cnt + i, problem.server_specs[i].max_in, edges_count++, true}
 			);
 		}
-
-		return g;
 	};
 
 	auto cmp_vm_ids_by_mem = [&](size_t lhs, size_t rhs) {
-		if (problem.vms[lhs].mem != problem.vms[rhs].mem) {
-			return problem.vms[lhs].mem > problem.vms[rhs].mem;
+		if (problem.vms.Table().Mem(lhs) != problem.vms.Table().Mem(rhs)) {
+			return problem.vms.Table().Mem(lhs) > problem.vms.Table().Mem(rhs);
 		}
 
 		return lhs < rhs;
 	};
 
-	Solution solution(problem.vms.size());
-	long double timer = 0;
+	TimeMoment timer = 0;
+
+	CycleBreaker& cycle_breaker = scratch.cycle_breaker;
+	std::vector<Movement>& group = scratch.group;
 
 	recalculate();
 
-	while (!misplaced_vms.empty()) {
-		if (available_for_migration.empty()) {
-			// oops, break the cycle (usually get here when misplaced vms quantity is 2-10)
-			VM move_vm = *misplaced_vms.rbegin();
+	while (!misplaced_vms.Empty()) {
+		if (available_for_migration.Empty() && misplaced_vms.Size() <= kExactSearchThreshold) {
+			// small deadlocked remainder: solve it exactly instead of breaking cycles greedily
+			AlgoExact::SearchResult exact = AlgoExact::SearchSchedule(
+				problem, vm_pos, AlgoExact::Objective::kMigrationTime, AlgoExact::kSolverLimits
+			);
 
-			size_t dest_server = problem.end_position.vm_server[move_vm.id];
+			if (exact.found) {
+				TimeMoment exact_end = 0;
+				for (const auto& move : exact.moves) {
+					perform_move(move.vm_id, move.from, move.to);
 
-			std::set<size_t>& raw_vms = *servers[dest_server].GetRawVMSet();
+					if (move.to == problem.end_position.vm_server[move.vm_id]) {
+						available_for_migration.Erase(move.vm_id);
+						misplaced_vms.Erase(move.vm_id);
+					}
+					exact_end = std::max(exact_end, move.start_moment + move.duration);
+					co_yield Movement{move.from, move.to, move.vm_id, timer + move.start_moment, move.duration};
+				}
 
-			std::vector<size_t> vm_sorted_by_mem(raw_vms.begin(), raw_vms.end());
-			std::sort(vm_sorted_by_mem.begin(), vm_sorted_by_mem.end(), cmp_vm_ids_by_mem);
-			std::reverse(vm_sorted_by_mem.begin(), vm_sorted_by_mem.end());
+				timer += exact_end;
+				continue;
+			}
+		}
 
-			size_t ptr_servers = 0;
+		if (available_for_migration.Empty()) {
+			// oops, break the cycles (usually get here when misplaced vms quantity is 2-10)
+			std::vector<size_t>& targets = scratch.targets;
+			targets = cycle_breaker.FindCycles(problem, vm_pos, misplaced_vms);
+			group.clear();
+			if (targets.empty()) {
+				targets.push_back(misplaced_vms.Back());
+			}
 
-			for (auto vm_id : vm_sorted_by_mem) {
-				if (dest_server == problem.end_position.vm_server[vm_id]) {
-					continue;
-				}
-				// find buffer server
-				size_t iters = 0;
-				
-				while (iters != servers.size()) {
-					if (servers[ptr_servers].CanFit(problem.vms[vm_id]) && ptr_servers != dest_server) {
-						perform_move(vm_id, dest_server, ptr_servers);
-
-						solution.vm_movements[vm_id].push_back(
-							Movement{
-								.from = dest_server,
-								.to = ptr_servers,
-								.start_moment = timer,
-								.duration = problem.vms[vm_id].migration_time,
-								.vm_id = vm_id
-							}
-						);
-						timer += problem.vms[vm_id].migration_time;
+			for (size_t target : targets) {
+				const VM& move_vm = problem.vms[target];
+				size_t dest_server = problem.end_position.vm_server[move_vm.id];
+
+				std::pmr::set<size_t>& raw_vms = *servers[dest_server].GetRawVMSet();
 
+				std::vector<size_t>& vm_sorted_by_mem = scratch.vm_sorted_by_mem;
+				vm_sorted_by_mem.assign(raw_vms.begin(), raw_vms.end());
+				std::sort(vm_sorted_by_mem.begin(), vm_sorted_by_mem.end(), cmp_vm_ids_by_mem);
+				std::reverse(vm_sorted_by_mem.begin(), vm_sorted_by_mem.end());
+
+				size_t ptr_servers = 0;
+
+				for (auto vm_id : vm_sorted_by_mem) {
+					if (dest_server == problem.end_position.vm_server[vm_id]) {
+						continue;
+					}
+					// find buffer server, preferably off the cycles
+					size_t to = problem.end_position.vm_server[vm_id];
+					size_t buffer = FindBuffer(
+						problem, servers, fit_index, vm_id, dest_server, to, ptr_servers, cycle_breaker.CycleServers()
+					);
+					if (buffer == FitIndex::kNone) {
+						buffer = FindBuffer(problem, servers, fit_index, vm_id, dest_server, to, ptr_servers, {});
+					}
+					if (buffer == FitIndex::kNone) {
 						break;
-					} else {
-						++iters;
-						ptr_servers = (ptr_servers + 1) % servers.size();
 					}
-				}
 
-				if (servers[dest_server].CanFit(move_vm)) {
-					break;
-				}
+					ptr_servers = buffer;
+					perform_move(vm_id, dest_server, ptr_servers);
 
-				if (iters == servers.size()) {
-					return std::nullopt;
+					TimeMoment duration = MigrationDuration(problem, vm_id, dest_server, ptr_servers);
+					TimeMoment start = cycle_breaker.PlanEviction(problem, dest_server, ptr_servers, timer, duration);
+					group.push_back(Movement{
+						static_cast<uint32_t>(dest_server), static_cast<uint32_t>(ptr_servers), static_cast<uint32_t>(vm_id), start, duration
+					});
+
+					if (servers[dest_server].CanFit(move_vm)) {
+						break;
+					}
 				}
 			}
+
+			timer = std::max(timer, cycle_breaker.GroupEnd());
+
+			if (available_for_migration.Empty()) {
+				co_return false;
+			}
+
+			std::stable_sort(group.begin(), group.end(), [](const Movement& lhs, const Movement& rhs) {
+				return lhs.start_moment < rhs.start_moment;
+			});
+			for (const auto& move : group) {
+				co_yield move;
+			}
 		}
 
-		Graph g = build_graph();
-		FlowState maxflow = DinicFindMaxFlow(g);
+		Graph& g = scratch.graph;
+		build_graph(g);
+		FlowState& maxflow = scratch.flow;
+		if (grouping == Grouping::kMinCost) {
+			MinCostMaxFlow(g, &maxflow);
+		} else {
+			DinicFindMaxFlow(g, &maxflow);
+		}
 
-		long double maxMigtime = 0;
+		TimeMoment maxMigtime = 0;
 		assert(maxflow.totalFlow != 0);
+		group.clear();
 
 		for (size_t i = 0; i < servers_cnt; ++i) {
 			for (const auto& e : g.adjLists[i]) {
 				if (e.rev) continue;
 				if (maxflow.flow[e.id] != 0) {
 					size_t vm_id = edge_vm_bijection[e.id];
-					
-					maxMigtime = std::max(maxMigtime, problem.vms[vm_id].migration_time);
-					solution.vm_movements[vm_id].push_back(
-						Movement{
-							.from = vm_pos[vm_id], 
-							.to = problem.end_position.vm_server[vm_id],
-							.start_moment = timer,
-							.duration = problem.vms[vm_id].migration_time,
-							.vm_id = vm_id
-						}
-					);
-
-					available_for_migration.erase(problem.vms[vm_id]);
-					misplaced_vms.erase(problem.vms[vm_id]);
+					TimeMoment duration = remaining_time(vm_id);
+
+					maxMigtime = std::max(maxMigtime, duration);
+					group.push_back(Movement{
+						static_cast<uint32_t>(vm_pos[vm_id]),
+						static_cast<uint32_t>(problem.end_position.vm_server[vm_id]),
+						static_cast<uint32_t>(vm_id),
+						timer,
+						duration
+					});
+
+					available_for_migration.Erase(vm_id);
+					misplaced_vms.Erase(vm_id);
 					perform_move(vm_id, vm_pos[vm_id], problem.end_position.vm_server[vm_id]);
 				}
 			}
 		}
 
+		// the parallelizer starts a round in order, the longest moves should not wait behind short ones
+		std::stable_sort(group.begin(), group.end(), [](const Movement& lhs, const Movement& rhs) {
+			return lhs.duration > rhs.duration;
+		});
+		for (const auto& move : group) {
+			co_yield move;
+		}
+
 		timer += maxMigtime;
 	}
 
-	return solution;
+	co_return true;
+}
+
+// the whole plan of `stream` at once
+std::optional<Solution> Collect(
+	const Problem& problem,
+	AlgoStatMaker* statmaker,
+	SolverWorkspace* workspace,
+	PlanStream (*stream)(const Problem&, AlgoStatMaker*, SolverWorkspace*)
+) {
+	SolverWorkspace local_workspace;
+	workspace = workspace ? workspace : &local_workspace;
+	return CollectPlan(stream(problem, statmaker, workspace), problem.vms.size(), &workspace->Get<Scratch>().solution);
+}
+
+PlanStream Stream(const Problem& problem, AlgoStatMaker* statmaker, SolverWorkspace* workspace) {
+	return Parallelizer::ParallelizeStream(StreamImpl(problem, statmaker, workspace, Grouping::kMaxFlow), problem, workspace);
+}
+
+PlanStream StreamMinCost(const Problem& problem, AlgoStatMaker* statmaker, SolverWorkspace* workspace) {
+	return Parallelizer::ParallelizeStream(StreamImpl(problem, statmaker, workspace, Grouping::kMinCost), problem, workspace);
+}
+
+std::optional<Solution> Solve(const Problem& problem, AlgoStatMaker* statmaker, SolverWorkspace* workspace) {
+	return Collect(problem, statmaker, workspace, Stream);
+}
+
+std::optional<Solution> SolveMinCost(const Problem& problem, AlgoStatMaker* statmaker, SolverWorkspace* workspace) {
+	return Collect(problem, statmaker, workspace, StreamMinCost);
+}
+
+struct EventScratch {
+	SolveArena arena;
+	std::vector<Server> servers;
+	FitIndex fit_index;
+	MemoryBucketQueue misplaced_vms;
+	std::vector<size_t> vm_pos;
+	std::vector<bool> in_flight;
+	std::vector<size_t> busy_out; // started migrations per server
+	std::vector<size_t> busy_in;
+	std::vector<TimeMoment> server_load; // migration time of waiting misplaced VMs from and to each server
+	std::vector<size_t> touched; // servers whose channels or free space changed at the current moment
+	std::vector<size_t> server_stamp;
+	std::vector<size_t> vm_stamp;
+	std::vector<size_t> candidates;
+	std::vector<size_t> edge_vm_bijection;
+	std::vector<size_t> out_node; // server -> node of the current graph, valid if stamped with current epoch
+	std::vector<size_t> in_node;
+	std::vector<size_t> out_stamp;
+	std::vector<size_t> in_stamp;
+	std::vector<std::pair<size_t, bool>> local_servers; // node - 2 -> {server, is input}
+	std::vector<size_t> evictions;
+	CycleBreaker cycle_breaker;
+	std::vector<size_t> targets;
+	std::vector<uint64_t> off_limits; // buffers not to use: cycle servers and servers without input channels
+	std::vector<uint64_t> no_input; // servers without input channels
+	std::vector<Movement> transfers; // min-heap by end moment
+	std::vector<Movement> started; // at the current moment, not emitted yet
+	UplinkLoad uplinks;
+	std::vector<std::vector<size_t>> uplink_waiting; // per pod: VMs held back only by its saturated uplink
+	std::vector<size_t> retry; // VMs to reconsider at the next scheduling
+	std::vector<size_t> uplink_reserved; // per pod, by candidates of the current scheduling
+	std::vector<size_t> cross_pod;
+	Graph graph;
+	FlowState flow;
+};
+
+PlanStream StreamEventDrivenImpl(
+	const Problem& problem,
+	AlgoStatMaker* statmaker,
+	SolverWorkspace* workspace,
+	Grouping grouping
+) {
+	/*
+		Same bipartite graph as in the rounds above, but planned in continuous time. Whenever
+		migrations complete, their servers get back channels and free space. Every move that can
+		start now has one of these servers as an endpoint (all others were saturated before),
+		so the flow is solved only over moves touching them, and chosen moves start immediately.
+		If nothing is in flight and nothing can start, every disjoint cycle is broken at once by
+		evicting one VM from the destination of its smallest VM to a buffer server (like in baseline).
+		Output is compact by construction and needs no parallelizer pass, and a move is final as
+		soon as it starts, so moves are emitted at every moment they start.
+	*/
+
+	AlgoStat stats;
+
+	size_t servers_cnt = problem.server_specs.size();
+
+	SolverWorkspace local_workspace;
+	EventScratch& scratch = (workspace ? workspace : &local_workspace)->Get<EventScratch>();
+
+	std::vector<Server>& servers = scratch.servers;
+	ResetServers(&servers, problem.server_specs, scratch.arena.Resource());
+
+	MemoryBucketQueue& misplaced_vms = scratch.misplaced_vms;
+	misplaced_vms.Reset(problem.vms.Table());
+	scratch.arena.Reset();
+
+	std::vector<size_t>& vm_pos = scratch.vm_pos;
+	vm_pos.assign(problem.start_position.vm_server.begin(), problem.start_position.vm_server.end());
+
+	for (const auto& vm : problem.vms) {
+		servers[vm_pos[vm.id]].ReceiveVM(vm);
+		servers[vm_pos[vm.id]].CancelReceivingVM(vm);
+	}
+
+	FitIndex& fit_index = scratch.fit_index;
+	fit_index.Reset(problem, servers);
+
+	std::vector<Movement>& started = scratch.started;
+	started.clear();
+
+	std::vector<bool>& in_flight = scratch.in_flight;
+	in_flight.assign(problem.vms.size(), false);
+	std::vector<size_t>& busy_out = scratch.busy_out;
+	std::vector<size_t>& busy_in = scratch.busy_in;
+	busy_out.assign(servers_cnt, 0);
+	busy_in.assign(servers_cnt, 0);
+
+	const Topology& topology = problem.topology;
+	UplinkLoad& uplinks = scratch.uplinks;
+	uplinks.Reset(topology);
+
+	std::vector<std::vector<size_t>>& uplink_waiting = scratch.uplink_waiting;
+	uplink_waiting.resize(topology.PodsCount());
+	for (auto& waiting : uplink_waiting) {
+		waiting.clear();
+	}
+	std::vector<size_t>& retry = scratch.retry;
+	retry.clear();
+
+	bool uplinks_limited = false;
+	for (size_t pod = 0; pod < topology.PodsCount(); ++pod) {
+		uplinks_limited |= topology.UplinkLimit(pod) != 0;
+	}
+
+	std::vector<TimeMoment>& server_load = scratch.server_load;
+	server_load.assign(servers_cnt, 0);
+
+	// of the direct move from the current position
+	auto remaining_time = [&](size_t vm_id) {
+		return MigrationDuration(problem, vm_id, vm_pos[vm_id], problem.end_position.vm_server[vm_id]);
+	};
+
+	auto add_load = [&](size_t vm_id, int sign) {
+		server_load[vm_pos[vm_id]] += sign * remaining_time(vm_id);
+		server_load[problem.end_position.vm_server[vm_id]] += sign * remaining_time(vm_id);
+	};
+
+	for (size_t vm_id = 0; vm_id < problem.vms.size(); ++vm_id) {
+		if (vm_pos[vm_id] != problem.end_position.vm_server[vm_id]) {
+			misplaced_vms.Insert(vm_id);
+			add_load(vm_id, 1);
+		}
+	}
+
+	std::vector<size_t>& touched = scratch.touched;
+	std::vector<size_t>& server_stamp = scratch.server_stamp;
+	std::vector<size_t>& vm_stamp = scratch.vm_stamp;
+	server_stamp.assign(servers_cnt, 0);
+	vm_stamp.assign(problem.vms.size(), 0);
+	size_t epoch = 1;
+
+	auto touch = [&](size_t server_id) {
+		if (server_stamp[server_id] != epoch) {
+			server_stamp[server_id] = epoch;
+			touched.push_back(server_id);
+		}
+	};
+
+	touched.clear();
+	for (size_t i = 0; i < servers_cnt; ++i) {
+		touch(i);
+	}
+
+	std::vector<Movement>& transfers = scratch.transfers;
+	transfers.clear();
+	auto ends_later = [](const Movement& lhs, const Movement& rhs) {
+		return lhs.start_moment + lhs.duration > rhs.start_moment + rhs.duration;
+	};
+
+	TimeMoment now = 0;
+
+	auto start_move = [&](size_t vm_id, size_t from, size_t to) {
+		const VM& vm = problem.vms[vm_id];
+
+		add_load(vm_id, -1);
+		servers[from].SendVM(vm);
+		servers[to].ReceiveVM(vm);
+		fit_index.UpdateServer(to);
+		++busy_out[from];
+		++busy_in[to];
+		uplinks.Start(from, to);
+		in_flight[vm_id] = true;
+		++stats.totalMigrations;
+
+		TimeMoment duration = MigrationDuration(problem, vm_id, from, to);
+		started.push_back(Movement{
+			static_cast<uint32_t>(from), static_cast<uint32_t>(to), static_cast<uint32_t>(vm_id), now, duration
+		});
+		transfers.push_back(started.back());
+		std::push_heap(transfers.begin(), transfers.end(), ends_later);
+	};
+
+	auto finish_move = [&](const Movement& move) {
+		const VM& vm = problem.vms[move.vm_id];
+
+		servers[move.from].CancelSendingVM(vm);
+		servers[move.to].CancelReceivingVM(vm);
+		fit_index.UpdateServer(move.from);
+		--busy_out[move.from];
+		--busy_in[move.to];
+		in_flight[move.vm_id] = false;
+
+		if (topology.Hop(move.from, move.to) == kCrossPod) {
+			for (size_t pod : {topology.Pod(move.from), topology.Pod(move.to)}) {
+				retry.insert(retry.end(), uplink_waiting[pod].begin(), uplink_waiting[pod].end());
+				uplink_waiting[pod].clear();
+			}
+		}
+		uplinks.Finish(move.from, move.to);
+		vm_pos[move.vm_id] = move.to;
+
+		if (move.to == problem.end_position.vm_server[move.vm_id]) {
+			misplaced_vms.Erase(move.vm_id);
+		} else {
+			add_load(move.vm_id, 1);
+		}
+
+		touch(move.from);
+		touch(move.to);
+	};
+
+	// everything but the uplinks allows the move
+	auto can_start_locally = [&](size_t vm_id) {
+		return misplaced_vms.Contains(vm_id) && !in_flight[vm_id] &&
+			servers[vm_pos[vm_id]].CanSendVM() &&
+			servers[problem.end_position.vm_server[vm_id]].CanReceiveVM(problem.vms[vm_id]);
+	};
+
+	auto can_start = [&](size_t vm_id) {
+		return can_start_locally(vm_id) && uplinks.CanStart(vm_pos[vm_id], problem.end_position.vm_server[vm_id]);
+	};
+
+	std::vector<size_t>& candidates = scratch.candidates;
+	std::vector<size_t>& edge_vm_bijection = scratch.edge_vm_bijection;
+	std::vector<size_t>& out_node = scratch.out_node;
+	std::vector<size_t>& in_node = scratch.in_node;
+	std::vector<size_t>& out_stamp = scratch.out_stamp;
+	std::vector<size_t>& in_stamp = scratch.in_stamp;
+	std::vector<std::pair<size_t, bool>>& local_servers = scratch.local_servers;
+	out_node.resize(servers_cnt);
+	in_node.resize(servers_cnt);
+	out_stamp.assign(servers_cnt, 0);
+	in_stamp.assign(servers_cnt, 0);
+
+	Graph& g = scratch.graph;
+	FlowState& flow = scratch.flow;
+
+	std::vector<size_t>& uplink_reserved = scratch.uplink_reserved;
+	std::vector<size_t>& cross_pod = scratch.cross_pod;
+
+	// uplinks are not a part of the flow: cross-pod candidates are cut down to the free uplink
+	// channels beforehand, the longest (or the most urgent) moves get them and the rest waits for the uplinks
+	auto reserve_uplinks = [&]() {
+		cross_pod.clear();
+		size_t kept = 0;
+
+		for (size_t vm_id : candidates) {
+			if (topology.Hop(vm_pos[vm_id], problem.end_position.vm_server[vm_id]) == kCrossPod) {
+				cross_pod.push_back(vm_id);
+			} else {
+				candidates[kept++] = vm_id;
+			}
+		}
+		candidates.resize(kept);
+
+		if (grouping == Grouping::kWeightedCompletion) {
+			// earliest deadline first, then heavy short moves
+			std::stable_sort(cross_pod.begin(), cross_pod.end(), [&](size_t lhs, size_t rhs) {
+				const VM& l = problem.vms[lhs];
+				const VM& r = problem.vms[rhs];
+				if (l.deadline != r.deadline) {
+					return l.deadline < r.deadline;
+				}
+				return l.priority * remaining_time(rhs) > r.priority * remaining_time(lhs);
+			});
+		} else {
+			std::stable_sort(cross_pod.begin(), cross_pod.end(), [&](size_t lhs, size_t rhs) {
+				return remaining_time(lhs) > remaining_time(rhs);
+			});
+		}
+		uplink_reserved.assign(uplink_waiting.size(), 0);
+
+		for (size_t vm_id : cross_pod) {
+			size_t from = topology.Pod(vm_pos[vm_id]), to = topology.Pod(problem.end_position.vm_server[vm_id]);
+
+			if (uplinks.Free(from) > uplink_reserved[from] && uplinks.Free(to) > uplink_reserved[to]) {
+				++uplink_reserved[from];
+				++uplink_reserved[to];
+				candidates.push_back(vm_id);
+				continue;
+			}
+
+			for (size_t pod : {from, to}) {
+				if (uplinks.Free(pod) <= uplink_reserved[pod]) {
+					uplink_waiting[pod].push_back(vm_id);
+				}
+			}
+		}
+	};
+
+	// starts a maximum set of moves touching `touched` servers, returns false if some of them did not fit together
+	auto schedule = [&]() -> bool {
+		candidates.clear();
+		++epoch;
+
+		auto add_candidate = [&](size_t vm_id) {
+			if (vm_stamp[vm_id] != epoch && can_start_locally(vm_id)) {
+				vm_stamp[vm_id] = epoch;
+				candidates.push_back(vm_id);
+			}
+		};
+
+		for (size_t vm_id : retry) {
+			add_candidate(vm_id);
+		}
+		retry.clear();
+
+		for (size_t server_id : touched) {
+			for (size_t vm_id : *servers[server_id].GetRawVMSet()) {
+				add_candidate(vm_id);
+			}
+			fit_index.ForEachIncoming(server_id, [&](size_t vm_id, bool fits) {
+				if (fits) {
+					add_candidate(vm_id);
+				}
+			});
+		}
+
+		touched.clear();
+
+		if (uplinks_limited) {
+			reserve_uplinks();
+		}
+
+		if (candidates.empty()) {
+			return true;
+		}
+
+		TimeMoment max_time = 0, max_load = 0;
+		long double max_ratio = 0;
+		if (grouping != Grouping::kMaxFlow) {
+			for (size_t vm_id : candidates) {
+				TimeMoment duration = remaining_time(vm_id);
+				max_time = std::max(max_time, duration);
+				max_ratio = std::max<long double>(max_ratio, problem.vms.Table().Priority(vm_id) / (duration > 0 ? duration : 1));
+			}
+			max_load = *std::max_element(server_load.begin(), server_load.end());
+		}
+		max_time = max_time > 0 ? max_time : 1;
+		max_load = max_load > 0 ? max_load : 1;
+		max_ratio = max_ratio > 0 ? max_ratio : 1;
+
+		// the graph holds only servers of candidate moves: sink, drain, then output and input nodes
+		for (auto& adj : g.adjLists) {
+			adj.clear();
+		}
+		g.sink = 0;
+		g.drain = 1;
+		size_t nodes_count = 2;
+		local_servers.clear();
+
+		auto local_node = [&](size_t server_id, bool input) {
+			size_t& node = input ? in_node[server_id] : out_node[server_id];
+			size_t& stamp = input ? in_stamp[server_id] : out_stamp[server_id];
+
+			if (stamp != epoch) {
+				stamp = epoch;
+				node = nodes_count++;
+				local_servers.push_back({server_id, input});
+			}
+			return node;
+		};
+
+		size_t edges_count = 0;
+		edge_vm_bijection.clear();
+
+		for (size_t vm_id : candidates) {
+			size_t from = local_node(vm_pos[vm_id], false);
+			size_t to = local_node(problem.end_position.vm_server[vm_id], true);
+			if (g.adjLists.size() < nodes_count) {
+				g.adjLists.resize(nodes_count);
+			}
+
+			int64_t cost = 0;
+			if (grouping == Grouping::kMinCost) {
+				TimeMoment route_load = server_load[vm_pos[vm_id]] + server_load[problem.end_position.vm_server[vm_id]];
+				cost = UrgencyCost(remaining_time(vm_id), route_load, max_time, max_load);
+			} else if (grouping == Grouping::kWeightedCompletion) {
+				cost = CompletionCost(problem.vms[vm_id], remaining_time(vm_id), now, max_ratio, max_load);
+			}
+
+			g.adjLists[from].push_back(Edge{from, to, 1, edges_count, false, cost});
+			g.adjLists[to].push_back(Edge{to, from, 1, edges_count++, true, -cost});
+			edge_vm_bijection.push_back(vm_id);
+		}
+
+		g.adjLists.resize(nodes_count);
+
+		for (size_t i = 0; i < local_servers.size(); ++i) {
+			auto [server_id, input] = local_servers[i];
+			size_t node = i + 2;
+
+			if (input) {
+				size_t free_in = problem.server_specs[server_id].max_in - busy_in[server_id];
+				g.adjLists[node].push_back(Edge{node, g.drain, free_in, edges_count, false});
+				g.adjLists[g.drain].push_back(Edge{g.drain, node, free_in, edges_count++, true});
+			} else {
+				size_t free_out = problem.server_specs[server_id].max_out - busy_out[server_id];
+				g.adjLists[g.sink].push_back(Edge{g.sink, node, free_out, edges_count, false});
+				g.adjLists[node].push_back(Edge{node, g.sink, free_out, edges_count++, true});
+			}
+		}
+
+		if (grouping != Grouping::kMaxFlow) {
+			MinCostMaxFlow(g, &flow);
+		} else {
+			DinicFindMaxFlow(g, &flow);
+		}
+
+		bool all_started = true;
+		for (size_t i = 0; i < edge_vm_bijection.size(); ++i) {
+			if (!flow.flow[i]) {
+				continue;
+			}
+
+			size_t vm_id = edge_vm_bijection[i];
+			if (!can_start(vm_id)) { // several moves into one server may not fit together
+				all_started = false;
+				touch(vm_pos[vm_id]);
+				continue;
+			}
+			start_move(vm_id, vm_pos[vm_id], problem.end_position.vm_server[vm_id]);
+		}
+
+		// channels reserved but left unused go to the VMs waiting for them right away
+		for (size_t pod = 0; pod < uplink_waiting.size(); ++pod) {
+			if (!uplink_waiting[pod].empty() && !uplinks.Saturated(pod)) {
+				retry.insert(retry.end(), uplink_waiting[pod].begin(), uplink_waiting[pod].end());
+				uplink_waiting[pod].clear();
+				all_started = false;
+			}
+		}
+
+		return all_started;
+	};
+
+	std::vector<size_t>& evictions = scratch.evictions;
+	CycleBreaker& cycle_breaker = scratch.cycle_breaker;
+	std::vector<size_t>& targets = scratch.targets;
+	std::vector<uint64_t>& off_limits = scratch.off_limits;
+	std::vector<uint64_t>& no_input = scratch.no_input;
+
+	// starts one eviction per disjoint cycle, returns false if none could start
+	auto break_cycles = [&]() -> bool {
+		targets = cycle_breaker.FindCycles(problem, vm_pos, misplaced_vms);
+		if (targets.empty()) {
+			targets.push_back(misplaced_vms.Back());
+		}
+		off_limits = cycle_breaker.CycleServers();
+		no_input.assign(off_limits.size(), 0);
+
+		bool started = false;
+
+		for (size_t target : targets) {
+			size_t dest_server = problem.end_position.vm_server[target];
+			if (!servers[dest_server].CanSendVM()) {
+				continue;
+			}
+			++stats.brokenCycles;
+
+			// smallest VMs first, they are the cheapest to push away
+			evictions.clear();
+			for (size_t vm_id : *servers[dest_server].GetRawVMSet()) {
+				if (problem.end_position.vm_server[vm_id] != dest_server) {
+					evictions.push_back(vm_id);
+				}
+			}
+			std::sort(evictions.begin(), evictions.end(), [&](size_t lhs, size_t rhs) {
+				if (problem.vms.Table().Mem(lhs) != problem.vms.Table().Mem(rhs)) {
+					return problem.vms.Table().Mem(lhs) < problem.vms.Table().Mem(rhs);
+				}
+				return lhs > rhs;
+			});
+
+			for (size_t vm_id : evictions) {
+				size_t to = problem.end_position.vm_server[vm_id];
+				size_t buffer = FindBuffer(problem, servers, fit_index, vm_id, dest_server, to, 0, off_limits);
+				if (buffer == FitIndex::kNone) {
+					buffer = FindBuffer(problem, servers, fit_index, vm_id, dest_server, to, 0, no_input);
+				}
+
+				if (buffer != FitIndex::kNone && uplinks.CanStart(dest_server, buffer)) {
+					++stats.migrationsBreakingCycles;
+					start_move(vm_id, dest_server, buffer);
+					started = true;
+
+					if (busy_in[buffer] >= problem.server_specs[buffer].max_in) {
+						off_limits[buffer / 64] |= uint64_t{1} << (buffer % 64);
+						no_input[buffer / 64] |= uint64_t{1} << (buffer % 64);
+					}
+					break;
+				}
+			}
+		}
+
+		return started;
+	};
+
+	while (!misplaced_vms.Empty()) {
+		while (!schedule()) {}
+
+		if (transfers.empty()) {
+			if (!break_cycles()) {
+				if (statmaker) {
+					statmaker->AddStat(stats);
+				}
+				co_return false;
+			}
+		}
+
+		for (const auto& move : started) {
+			co_yield move;
+		}
+		started.clear();
+
+		if (transfers.empty()) {
+			continue;
+		}
+
+		// complete every transfer ending at the next moment
+		now = transfers.front().start_moment + transfers.front().duration;
+		while (!transfers.empty() && transfers.front().start_moment + transfers.front().duration == now) {
+			std::pop_heap(transfers.begin(), transfers.end(), ends_later);
+			finish_move(transfers.back());
+			transfers.pop_back();
+		}
+	}
+
+	if (statmaker) {
+		statmaker->AddStat(stats);
+	}
+	co_return true;
+}
+
+PlanStream StreamEventDriven(const Problem& problem, AlgoStatMaker* statmaker, SolverWorkspace* workspace) {
+	return StreamEventDrivenImpl(problem, statmaker, workspace, Grouping::kMinCost);
+}
+
+PlanStream StreamWeightedCompletion(const Problem& problem, AlgoStatMaker* statmaker, SolverWorkspace* workspace) {
+	return StreamEventDrivenImpl(problem, statmaker, workspace, Grouping::kWeightedCompletion);
+}
+
+std::optional<Solution> SolveEventDriven(const Problem& problem, AlgoStatMaker* statmaker, SolverWorkspace* workspace) {
+	return Collect(problem, statmaker, workspace, StreamEventDriven);
 }
 
-std::optional<Solution> Solve(const Problem& problem, AlgoStatMaker* statmaker) {
-	return Parallelizer::ParallelizeSolution(SolveImpl, problem, statmaker);
+std::optional<Solution> SolveWeightedCompletion(const Problem& problem, AlgoStatMaker* statmaker, SolverWorkspace* workspace) {
+	return Collect(problem, statmaker, workspace, StreamWeightedCompletion);
 }
 
 }
\ No newline at end of file
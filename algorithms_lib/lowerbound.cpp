@@ -5,40 +5,52 @@ namespace AlgoLowerBound {
 long double CountTimespanLowerBound(const Problem& problem) {
 	long double res = 0;
 
-	std::vector<std::vector<VM>> moving_in_vms(problem.server_specs.size());
-	std::vector<std::vector<VM>> moving_out_vms(problem.server_specs.size());
-
-	for (const VM& vm : problem.vms) {
-		if (problem.end_position.vm_server[vm.id] 
-			!= problem.start_position.vm_server[vm.id]) {
-			moving_in_vms[problem.end_position.vm_server[vm.id]].push_back(vm);
-			moving_out_vms[problem.start_position.vm_server[vm.id]].push_back(vm);
+	const VMTable& vms = problem.vms.Table();
+	std::span<const TimeMoment> migration_time = vms.MigrationTimes();
+	const std::vector<size_t>& start = problem.start_position.vm_server;
+	const std::vector<size_t>& end = problem.end_position.vm_server;
+
+	// at best the moves into (out of) a server are spread evenly over its channels
+	std::vector<TimeMoment> in_time(problem.server_specs.size(), 0);
+	std::vector<TimeMoment> out_time(problem.server_specs.size(), 0);
+
+	for (size_t vm_id = 0; vm_id < vms.Size(); ++vm_id) {
+		if (start[vm_id] != end[vm_id]) {
+			in_time[end[vm_id]] += migration_time[vm_id];
+			out_time[start[vm_id]] += migration_time[vm_id];
 		}
 	}
 
-	auto sort_by_migration_time = [](const VM& lhs, const VM& rhs) -> bool {
-		return lhs.migration_time >= rhs.migration_time;
-	};
+	for (size_t i = 0; i < problem.server_specs.size(); ++i) {
+		res = std::max(res, TimeToUnits(in_time[i]) / problem.server_specs[i].max_in);
+		res = std::max(res, TimeToUnits(out_time[i]) / problem.server_specs[i].max_out);
+	}
+
+	const Topology& topology = problem.topology;
+	if (topology.Empty()) {
+		return res;
+	}
 
-	auto count_lowerbound = [](const std::vector<VM>& vms, size_t round_capacity) -> long double {
-		long double timespan_lowerbound = 0;
-		for (const auto& vm : vms) {
-			timespan_lowerbound += vm.migration_time;
+	// no path is faster than the cheapest hop class
+	res *= *std::min_element(topology.hop_multiplier.begin(), topology.hop_multiplier.end());
+
+	// a VM changing pods crosses the uplinks of both pods at least once
+	std::vector<TimeMoment> uplink_time(topology.PodsCount(), 0);
+	for (size_t vm_id = 0; vm_id < vms.Size(); ++vm_id) {
+		size_t from = topology.Pod(start[vm_id]);
+		size_t to = topology.Pod(end[vm_id]);
+
+		if (from != to) {
+			uplink_time[from] += migration_time[vm_id];
+			uplink_time[to] += migration_time[vm_id];
 		}
-		timespan_lowerbound /= round_capacity;
-		return timespan_lowerbound;
-	};
-
-	for (size_t i = 0; i < moving_in_vms.size(); ++i) {
-		std::vector<VM>& vms = moving_in_vms[i];
-		std::sort(vms.begin(), vms.end(), sort_by_migration_time);
-		res = std::max(res, count_lowerbound(vms, problem.server_specs[i].max_in));
 	}
 
-	for (size_t i = 0; i < moving_out_vms.size(); ++i) {
-		std::vector<VM>& vms = moving_out_vms[i];
-		std::sort(vms.begin(), vms.end(), sort_by_migration_time);
-		res = std::max(res, count_lowerbound(vms, problem.server_specs[i].max_out));
+	for (size_t pod = 0; pod < uplink_time.size(); ++pod) {
+		if (topology.UplinkLimit(pod)) {
+			res = std::max(res,
+				TimeToUnits(uplink_time[pod]) * topology.hop_multiplier[kCrossPod] / topology.UplinkLimit(pod));
+		}
 	}
 
 	return res;
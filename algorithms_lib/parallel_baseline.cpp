@@ -4,8 +4,16 @@
 
 namespace AlgoParallelBaseline {
 
-std::optional<Solution> Solve(const Problem& problem, AlgoStatMaker* statmaker) {
-	return Parallelizer::ParallelizeSolution(AlgoBaseline::Solve, problem, statmaker);
+PlanStream Stream(const Problem& problem, AlgoStatMaker* statmaker, SolverWorkspace* workspace) {
+	return Parallelizer::ParallelizeStream(AlgoBaseline::Stream(problem, statmaker, workspace), problem, workspace);
 }
 
-}
\ No newline at end of file
+std::optional<Solution> Solve(const Problem& problem, AlgoStatMaker* statmaker, SolverWorkspace* workspace) {
+	SolverWorkspace local_workspace;
+	workspace = workspace ? workspace : &local_workspace;
+	return CollectPlan(
+		Stream(problem, statmaker, workspace), problem.vms.size(), &workspace->Get<Parallelizer::Scratch>().solution
+	);
+}
+
+}
@@ -0,0 +1,84 @@
+#include "parallelizer.h"
+
+namespace Parallelizer {
+
+PlanStream ParallelizeStream(PlanStream plan, const Problem& problem, SolverWorkspace* workspace) {
+	SolverWorkspace local_workspace;
+	Scratch& scratch = (workspace ? workspace : &local_workspace)->Get<Scratch>();
+
+	std::vector<Server>& servers = scratch.servers;
+	ResetServers(&servers, problem.server_specs, scratch.arena.Resource());
+
+	std::pmr::multimap<TimeMoment, Movement>& migrations = scratch.migrations;
+	migrations.clear();
+	scratch.arena.Reset();
+
+	UplinkLoad& uplinks = scratch.uplinks;
+	uplinks.Reset(problem.topology);
+
+	for (const auto& vm : problem.vms) {
+		servers[problem.start_position.vm_server[vm.id]].ReceiveVM(vm);
+		servers[problem.start_position.vm_server[vm.id]].CancelReceivingVM(vm);
+	}
+
+	std::vector<Movement>& started = scratch.started;
+	started.clear();
+
+	TimeMoment timer = 0;
+	bool has_next = plan.Next();
+
+	auto add_new_migrations_to_solution = [&]() {
+		while (has_next) {
+			Movement move = plan.Value();
+
+			// a VM hopping through a buffer waits until its previous move lands
+			bool landed = servers[move.from].HasVM(move.vm_id);
+
+			if (landed && servers[move.from].CanSendVM() && servers[move.to].CanReceiveVM(problem.vms[move.vm_id]) &&
+				uplinks.CanStart(move.from, move.to)) {
+				servers[move.from].SendVM(problem.vms[move.vm_id]);
+				servers[move.to].ReceiveVM(problem.vms[move.vm_id]);
+				uplinks.Start(move.from, move.to);
+				migrations.insert({timer + move.duration, move});
+				started.push_back(Movement{move.from, move.to, move.vm_id, timer, move.duration});
+				has_next = plan.Next();
+			} else {
+				break;
+			}
+		}
+	};
+
+	add_new_migrations_to_solution();
+
+	while (!started.empty()) {
+		for (const auto& move : started) {
+			co_yield move;
+		}
+		started.clear();
+
+		// every started migration is emitted, the next ones wait for some of them to end
+		while (started.empty() && !migrations.empty()) {
+			auto [moment, move] = *(migrations.begin());
+			migrations.erase(migrations.begin());
+
+			servers[move.from].CancelSendingVM(problem.vms[move.vm_id]);
+			servers[move.to].CancelReceivingVM(problem.vms[move.vm_id]);
+			uplinks.Finish(move.from, move.to);
+
+			timer = moment;
+			add_new_migrations_to_solution();
+		}
+	}
+
+	// a movement which cannot start even on an idle cluster breaks the plan, like an incomplete input
+	co_return !has_next && plan.Solved();
+}
+
+PlanStream ReplayPlan(std::span<const Movement> moves) {
+	for (const auto& move : moves) {
+		co_yield move;
+	}
+	co_return true;
+}
+
+}
@@ -1,24 +1,50 @@
+#pragma once
+
+#include "../common/arena.h"
+#include "../common/plan_stream.h"
 #include "../common/solution.h"
+#include "../common/workspace.h"
 #include "../testenv_lib/algo_stat_maker.h"
 
+#include <algorithm>
 #include <map>
+#include <span>
 
 namespace Parallelizer {
 
+	struct Scratch {
+		SolveArena arena;
+		SolutionBuilder solution;
+		std::vector<Movement> moves;
+		std::vector<Movement> started; // not emitted yet
+		std::vector<Server> servers;
+		UplinkLoad uplinks;
+		std::pmr::multimap<TimeMoment, Movement> migrations{arena.Resource()}; // migrations are sorted by end times
+	};
+
+	/*
+		Restarts every movement of `plan` as early as channels, free space, uplinks and the VM's
+		previous hop allow, keeping their order, so `plan` has to come in order of start moments.
+		The plan is pulled only as far as the restarted movements need it.
+	*/
+	PlanStream ParallelizeStream(PlanStream plan, const Problem& problem, SolverWorkspace* workspace);
+
+	PlanStream ReplayPlan(std::span<const Movement> moves); // a complete plan already in memory
+
 	template<class Algo>
-	std::optional<Solution> ParallelizeSolution(Algo solver, const Problem& problem, AlgoStatMaker* statmaker) {
-		std::optional<Solution> res = solver(problem, statmaker);
+	std::optional<Solution> ParallelizeSolution(Algo solver, const Problem& problem, AlgoStatMaker* statmaker, SolverWorkspace* workspace) {
+		std::optional<Solution> res = solver(problem, statmaker, workspace);
 
 		if (!res) {
 			return res;
 		} 
 
-		std::vector<Movement> moves;
-		for (const auto& vm_moves : res->vm_movements) {
-			for (const auto& move : vm_moves) {
-				moves.push_back(move);
-			}
-		}
+		SolverWorkspace local_workspace;
+		workspace = workspace ? workspace : &local_workspace;
+		Scratch& scratch = workspace->Get<Scratch>();
+
+		std::vector<Movement>& moves = scratch.moves;
+		moves.assign(res->GetMovements().begin(), res->GetMovements().end());
 
 		std::sort(moves.begin(), moves.end(), 
 			[&](const Movement& lhs, const Movement& rhs) 
@@ -26,62 +52,6 @@ namespace Parallelizer {
 			return lhs.start_moment < rhs.start_moment;
 		});
 
-		std::multimap<long double, Movement> migrations; // migrations are sorted by end times
-
-		std::vector<Server> servers;
-		servers.reserve(problem.server_specs.size());
-
-		for (size_t i = 0; i < problem.server_specs.size(); ++i) {
-			servers.emplace_back(problem.server_specs[i], i);
-		}
-
-		for (const auto& vm : problem.vms) {
-			servers[problem.start_position.vm_server[vm.id]].ReceiveVM(vm);
-			servers[problem.start_position.vm_server[vm.id]].CancelReceivingVM(vm);
-		}
-
-		Solution new_solution(res->vm_movements.size());
-
-		long double timer = 0;
-		size_t ptr = 0;
-
-		auto add_new_migrations_to_solution = [&]() {
-			while (ptr < moves.size()) {
-				auto move = moves[ptr];
-
-				if (servers[move.from].CanSendVM() && servers[move.to].CanReceiveVM(problem.vms[move.vm_id])) {
-					servers[move.from].SendVM(problem.vms[move.vm_id]);
-					servers[move.to].ReceiveVM(problem.vms[move.vm_id]);
-					migrations.insert({timer + move.duration, move});
-					new_solution.vm_movements[move.vm_id].push_back(
-						Movement{
-							.from = move.from,
-							.to = move.to,
-							.start_moment = timer,
-							.duration = move.duration,
-							.vm_id = move.vm_id
-						}
-					);
-					++ptr;
-				} else {
-					break;
-				}
-			}
-		};
-
-		add_new_migrations_to_solution();
-
-		while (!migrations.empty()) {
-			auto [moment, move] = *(migrations.begin());
-			migrations.erase(migrations.begin());
-
-			servers[move.from].CancelSendingVM(problem.vms[move.vm_id]);
-			servers[move.to].CancelReceivingVM(problem.vms[move.vm_id]);
-
-			timer = moment;
-			add_new_migrations_to_solution();
-		}
-
-		return new_solution;
+		return CollectPlan(ParallelizeStream(ReplayPlan(moves), problem, workspace), res->VMCount(), &scratch.solution);
 	}
-}
\ No newline at end of file
+}
@@ -0,0 +1,43 @@
+#include "registry.h"
+#include "algorithms.h"
+
+namespace AlgoRegistry {
+
+const std::vector<AlgorithmInfo>& Algorithms() {
+	static const std::vector<AlgorithmInfo> kAlgorithms = {
+		{"baseline", AlgoBaseline::Solve, 2,
+			"one move at a time, deadlocks broken by parking VMs on buffer servers",
+			AlgoBaseline::Stream},
+		{"parallel_baseline", AlgoParallelBaseline::Solve, 2,
+			"baseline compacted by the parallelizer",
+			AlgoParallelBaseline::Stream},
+		{"flow_grouping", AlgoFlowGrouping::Solve, 6,
+			"rounds are maximum flows in the server bipartite graph, small deadlocks solved exactly",
+			AlgoFlowGrouping::Stream},
+		{"flow_grouping_mincost", AlgoFlowGrouping::SolveMinCost, 6,
+			"rounds are min-cost maximum flows preferring long migrations and busy servers",
+			AlgoFlowGrouping::StreamMinCost},
+		{"flow_grouping_events", AlgoFlowGrouping::SolveEventDriven, 2,
+			"continuous-time flow grouping without round barriers",
+			AlgoFlowGrouping::StreamEventDriven},
+		{"flow_grouping_weighted", AlgoFlowGrouping::SolveWeightedCompletion, 2,
+			"continuous-time flow grouping by deadlines, then by priority per migration time",
+			AlgoFlowGrouping::StreamWeightedCompletion},
+		{"dependency_graph", AlgoDependencyGraph::Solve, 1,
+			"blocked-by graph condensed into SCCs, sink cycles broken by cheapest evictions"},
+	};
+
+	return kAlgorithms;
+}
+
+const AlgorithmInfo* FindAlgorithm(std::string_view name) {
+	for (const auto& algo : Algorithms()) {
+		if (algo.name == name) {
+			return &algo;
+		}
+	}
+
+	return nullptr;
+}
+
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "../common/plan_stream.h"
+#include "../common/solution.h"
+#include "../common/workspace.h"
+#include "../testenv_lib/algo_stat_maker.h"
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace AlgoRegistry {
+	using SolverFn = std::optional<Solution> (*)(const Problem&, AlgoStatMaker*, SolverWorkspace*);
+	using StreamFn = PlanStream (*)(const Problem&, AlgoStatMaker*, SolverWorkspace*);
+
+	struct AlgorithmInfo {
+		std::string_view name;
+		SolverFn solve;
+		uint32_t version; // bump whenever the plans produced for the same problem change
+		std::string_view description;
+		StreamFn stream = nullptr; // same plan movement by movement, null if the algorithm cannot stream
+	};
+
+	const std::vector<AlgorithmInfo>& Algorithms();
+
+	const AlgorithmInfo* FindAlgorithm(std::string_view name); // nullptr for unknown names
+}
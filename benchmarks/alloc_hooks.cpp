@@ -0,0 +1,89 @@
+// Replacements of the global operator new/delete feeding AllocProfile, see testenv_lib/alloc_profile.h.
+// Every block carries a 16-byte header right before the user pointer: its size and the offset
+// of the user pointer from the start of the underlying malloc block.
+
+#include <cstdlib>
+#include <new>
+
+#include "../testenv_lib/alloc_profile.h"
+
+namespace {
+
+constexpr size_t kHeader = 16;
+
+struct BlockHeader {
+	size_t size;
+	size_t offset;
+};
+
+const bool kInstalled = (AllocProfile::MarkInstalled(), true);
+
+void* Allocate(size_t size, size_t alignment) noexcept {
+	size_t offset = alignment > kHeader ? alignment : kHeader;
+	void* raw = alignment > kHeader
+		? std::aligned_alloc(alignment, (offset + size + alignment - 1) / alignment * alignment)
+		: std::malloc(offset + size);
+
+	if (!raw) {
+		return nullptr;
+	}
+
+	char* user = static_cast<char*>(raw) + offset;
+	*reinterpret_cast<BlockHeader*>(user - kHeader) = {size, offset};
+	AllocProfile::OnAllocate(size);
+	return user;
+}
+
+void* AllocateOrThrow(size_t size, size_t alignment) {
+	void* ptr = Allocate(size, alignment);
+	while (!ptr) {
+		std::new_handler handler = std::get_new_handler();
+		if (!handler) {
+			throw std::bad_alloc();
+		}
+		handler();
+		ptr = Allocate(size, alignment);
+	}
+	return ptr;
+}
+
+void Free(void* ptr) noexcept {
+	if (!ptr) {
+		return;
+	}
+
+	char* user = static_cast<char*>(ptr);
+	BlockHeader header = *reinterpret_cast<BlockHeader*>(user - kHeader);
+	AllocProfile::OnFree(header.size);
+	std::free(user - header.offset);
+}
+
+}
+
+void* operator new(size_t size) { return AllocateOrThrow(size, 0); }
+void* operator new[](size_t size) { return AllocateOrThrow(size, 0); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return Allocate(size, 0); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return Allocate(size, 0); }
+
+void* operator new(size_t size, std::align_val_t align) { return AllocateOrThrow(size, static_cast<size_t>(align)); }
+void* operator new[](size_t size, std::align_val_t align) { return AllocateOrThrow(size, static_cast<size_t>(align)); }
+void* operator new(size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {
+	return Allocate(size, static_cast<size_t>(align));
+}
+void* operator new[](size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {
+	return Allocate(size, static_cast<size_t>(align));
+}
+
+void operator delete(void* ptr) noexcept { Free(ptr); }
+void operator delete[](void* ptr) noexcept { Free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { Free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { Free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { Free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { Free(ptr); }
+
+void operator delete(void* ptr, std::align_val_t) noexcept { Free(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { Free(ptr); }
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept { Free(ptr); }
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept { Free(ptr); }
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { Free(ptr); }
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { Free(ptr); }
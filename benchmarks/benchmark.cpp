@@ -1,63 +1,326 @@
+#include <filesystem>
+#include <fstream>
 #include <iostream>
 
 #include <glog/logging.h>
 
+#include "../common/solution_io.h"
+#include "../testenv_lib/bench_report.h"
+#include "../testenv_lib/solution_cache.h"
 #include "../testenv_lib/test_environment.h"
 #include "../testenv_lib/test_generator.h"
-#include "../algorithms_lib/algorithms.h"
+#include "../algorithms_lib/registry.h"
 
 // PROTO
 #include "../proto/test_case.pb.h"
 #include "../proto/metrics.pb.h"
 
 
-#include <google/protobuf/util/json_util.h>
+constexpr long double kDefaultRegressionThreshold = 0.02;
+
+void PrintUsage() {
+	std::cout << "USAGE: ./benchmark [--warmup W] [--repeat N] [--cache DIR [--revalidate 1]] ALGO_NAME[,ALGO_NAME...] DATASET_INPUT_PATH METRICS_JSON_OUTPUT_PATH\n"
+		<< "       ./benchmark compare BASE_METRICS_JSON CANDIDATE_METRICS_JSON [--threshold PERCENT] [--algo ALGO_NAME]\n"
+		<< "       ./benchmark validate DATASET_INPUT_PATH SCHEDULES_PATH METRICS_JSON_OUTPUT_PATH\n"
+		<< "       ./benchmark list\n"
+		<< "Several algorithms share one pass over the dataset and produce combined results,\n"
+		<< "compare picks a run out of them with --algo.\n"
+		<< "With --cache, results of (test, algorithm version) pairs solved before are read from DIR;\n"
+		<< "--revalidate re-checks cached schedules and recomputes their plan metrics.\n"
+		<< "--schedules DIR dumps every schedule to DIR/ALGO_NAME.sched, validate checks and scores such a file.\n"
+		<< "--perf 1 adds hardware counters of solver calls and validation where perf_event_open is allowed.\n";
+}
+
+void PrintAlgorithms(std::ostream& out) {
+	for (const auto& algo : AlgoRegistry::Algorithms()) {
+		out << algo.name << " (v" << algo.version << "): " << algo.description << '\n';
+	}
+}
+
+// `a,b,c` -> registry entries, nullopt if some name is unknown
+std::optional<std::vector<const AlgoRegistry::AlgorithmInfo*>> ParseAlgorithms(const std::string& list) {
+	std::vector<const AlgoRegistry::AlgorithmInfo*> result;
+	size_t begin = 0;
+
+	while (begin <= list.size()) {
+		size_t end = std::min(list.find(',', begin), list.size());
+		std::string name = list.substr(begin, end - begin);
+		const AlgoRegistry::AlgorithmInfo* algo = AlgoRegistry::FindAlgorithm(name);
+
+		if (!algo) {
+			LOG(ERROR) << "Unknown algorithm `" << name << "`";
+			return std::nullopt;
+		}
+
+		result.push_back(algo);
+		begin = end + 1;
+	}
+
+	return result;
+}
+
+// splits `--flag value` pairs from positional arguments
+bool ParseArgs(
+	int argc,
+	const char* argv[],
+	std::vector<std::string>* positional,
+	std::map<std::string, std::string>* flags
+) {
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+
+		if (arg.starts_with("--")) {
+			if (i + 1 == argc) {
+				return false;
+			}
+			(*flags)[arg.substr(2)] = argv[++i];
+		} else {
+			positional->push_back(arg);
+		}
+	}
+
+	return true;
+}
+
+int Compare(const std::vector<std::string>& args, const std::map<std::string, std::string>& flags) {
+	long double threshold = kDefaultRegressionThreshold;
+	if (flags.contains("threshold")) {
+		threshold = std::stold(flags.at("threshold")) / 100;
+	}
+
+	Metrics::MetricsSet base, candidate;
+	if (flags.contains("algo")) {
+		base = SelectRun(LoadBenchmarkResults(args[1]), flags.at("algo"));
+		candidate = SelectRun(LoadBenchmarkResults(args[2]), flags.at("algo"));
+	} else {
+		base = LoadMetricsSet(args[1]);
+		candidate = LoadMetricsSet(args[2]);
+	}
+
+	std::vector<MetricComparison> comparison = CompareMetricsSets(base, candidate, threshold);
+	PrintComparison(comparison, std::cout);
+
+	bool regressed = std::any_of(comparison.begin(), comparison.end(), [](const MetricComparison& metric) {
+		return metric.regression;
+	});
+
+	if (regressed) {
+		LOG(WARNING) << "Regressions above " << 100 * threshold << "% found";
+		return 2;
+	}
+
+	return 0;
+}
+
+int Validate(const std::vector<std::string>& args, const std::map<std::string, std::string>& flags) {
+	DataSet::DataSet dataset = LoadTests(args[1]);
+
+	std::map<uint64_t, const DataSet::TestCase*> tests;
+	for (const auto& test : dataset.tests()) {
+		tests[test.id()] = &test;
+	}
+
+	std::ifstream file(args[2], std::ios::in | std::ios::binary);
+	if (!file.is_open()) {
+		throw std::invalid_argument("Cannot load schedules from `" + args[2] + "`");
+	}
+
+	TestEnvironment test_env(std::make_unique<RealLifeGenerator>(42, 15, 100, 1000));
+	if (flags.contains("perf") && flags.at("perf") != "0") {
+		test_env.EnablePerfCounters();
+	}
+
+	Metrics::MetricsSet measurements;
+	size_t solved = 0;
+
+	try {
+		ScheduleReader reader(file);
+
+		uint64_t test_id;
+		Solution solution;
+		while (reader.Read(&test_id, &solution)) {
+			if (!tests.contains(test_id)) {
+				throw std::runtime_error("schedule of unknown test #" + std::to_string(test_id));
+			}
+
+			Problem problem = ConvertTestCaseToProblem(*tests[test_id]);
+			try {
+				solved += test_env.ReplayTest(problem, test_id, solution, Metrics::Metrics(), true, &measurements);
+			} catch (const std::runtime_error& e) {
+				LOG(ERROR) << "Schedule of test #" << test_id << " is rejected: " << e.what();
+			}
+		}
+	} catch (const std::runtime_error& e) {
+		LOG(ERROR) << "Corrupt schedules file `" << args[2] << "`: " << e.what();
+		return 1;
+	}
+
+	test_env.FinishMeasurements(&measurements, dataset.tests_size(), solved);
+	LOG(INFO) << "Valid schedules: " << solved << " out of " << dataset.tests_size() << " tests";
+	test_env.PrintMeasurements(std::cout);
+
+	LOG(INFO) << "Flushing metrics to `" << args[3] << "`";
+	DumpMetricsSet(measurements, args[3]);
+
+	return 0;
+}
 
 int main(int argc, const char* argv[]) {
 	FLAGS_logtostderr = true;
     google::InitGoogleLogging(argv[0]);
     google::InstallFailureSignalHandler();
 
-    if (argc < 4) {
-    	std::cout << "USAGE: ./benchmark ALGO_NAME DATASET_INPUT_PATH METRICS_JSON_OUTPUT_PATH\n"; 
-    	return 1;
-    }
+	std::vector<std::string> args;
+	std::map<std::string, std::string> flags;
 
-	TestEnvironment test_env(std::make_unique<RealLifeGenerator>(42, 15, 100, 1000));
-	DataSet::DataSet dataset = LoadTests(argv[2]);
-	TestEnvironment::AlgorithmCallback algo = AlgoBaseline::Solve;
-
-	std::cout << "Using algorithm: `";
-	if (std::string{argv[1]} == "flow_grouping") {
-		std::cout << argv[1];
-		algo = AlgoFlowGrouping::Solve;
-	} else if (std::string{argv[1]} == "parallel_baseline") {
-		std::cout << argv[1];
-		algo = AlgoParallelBaseline::Solve;
-	} else {
-		std::cout << "baseline";
+	if (!ParseArgs(argc, argv, &args, &flags)) {
+		PrintUsage();
+		return 1;
+	}
+
+	if (args.size() == 1 && args[0] == "list") {
+		PrintAlgorithms(std::cout);
+		return 0;
+	}
+
+	if (args.size() < 3) {
+		PrintUsage();
+		return 1;
+	}
+
+	if (args[0] == "compare") {
+		return Compare(args, flags);
 	}
 
-	std::cout << "`\n";
+	if (args[0] == "validate") {
+		if (args.size() < 4) {
+			PrintUsage();
+			return 1;
+		}
+		return Validate(args, flags);
+	}
+
+	auto algorithms = ParseAlgorithms(args[0]);
+	if (!algorithms) {
+		std::cout << "Available algorithms:\n";
+		PrintAlgorithms(std::cout);
+		return 1;
+	}
+
+	DataSet::DataSet dataset = LoadTests(args[1]);
+
+	// one environment per algorithm keeps workspaces and accumulators apart
+	std::vector<std::unique_ptr<TestEnvironment>> environments;
+	std::vector<Metrics::MetricsSet> measurements(algorithms->size());
+	std::vector<size_t> solved(algorithms->size(), 0);
+
+	for (size_t k = 0; k < algorithms->size(); ++k) {
+		environments.push_back(std::make_unique<TestEnvironment>(std::make_unique<RealLifeGenerator>(42, 15, 100, 1000)));
+		environments[k]->SetRepetitions(
+			flags.contains("warmup") ? std::stoul(flags.at("warmup")) : 0,
+			flags.contains("repeat") ? std::stoul(flags.at("repeat")) : 1
+		);
+
+		if (flags.contains("perf") && flags.at("perf") != "0") {
+			environments[k]->EnablePerfCounters();
+		}
+		if ((*algorithms)[k]->stream) {
+			environments[k]->SetStreamingSolver((*algorithms)[k]->stream);
+		}
+	}
 
 // ------- Run ------------------------
 
-	Metrics::MetricsSet measurements = test_env.RunTestsFromDataSet(dataset, algo, nullptr);
-	LOG(INFO) << "Solved: " << measurements.solved() << " out of " << measurements.tests();
+	std::optional<SolutionCache> cache;
+	if (flags.contains("cache")) {
+		cache.emplace(flags.at("cache"));
+	}
+	bool revalidate = flags.contains("revalidate") && flags.at("revalidate") != "0";
 
-// ------------ Flush -----------------
+	// one schedule stream per algorithm
+	std::vector<std::ofstream> schedule_files;
+	std::vector<ScheduleWriter> schedule_writers;
+	if (flags.contains("schedules")) {
+		std::filesystem::create_directories(flags.at("schedules"));
+		schedule_files.reserve(algorithms->size());
+		schedule_writers.reserve(algorithms->size());
 
-	std::string result;
-	google::protobuf::util::JsonPrintOptions options;
-	options.add_whitespace = true;
-	options.preserve_proto_field_names = true;
+		for (const auto* algo : *algorithms) {
+			std::filesystem::path path = std::filesystem::path(flags.at("schedules")) / (std::string(algo->name) + ".sched");
+			schedule_files.emplace_back(path, std::ios::binary | std::ios::trunc | std::ios::out);
+			if (!schedule_files.back().is_open()) {
+				throw std::invalid_argument("Cannot dump schedules to `" + path.string() + "`");
+			}
+			schedule_writers.emplace_back(schedule_files.back());
+		}
+	}
+
+	for (const auto& test : dataset.tests()) {
+		Problem problem = ConvertTestCaseToProblem(test);
+
+		for (size_t k = 0; k < algorithms->size(); ++k) {
+			const AlgoRegistry::AlgorithmInfo& algo = *(*algorithms)[k];
+			std::string key = cache ? SolutionCache::Key(test, algo.name, algo.version) : "";
+			std::optional<SolutionCache::Entry> entry = cache ? cache->Lookup(algo.name, key) : std::nullopt;
+
+			if (entry) {
+				solved[k] += environments[k]->ReplayTest(
+					problem, test.id(), entry->solution, entry->metrics, revalidate, &measurements[k]
+				);
+			} else {
+				bool is_solved = environments[k]->RunTest(problem, test.id(), algo.solve, &measurements[k]);
+				solved[k] += is_solved;
+
+				if (cache) {
+					cache->Store(
+						algo.name,
+						key,
+						environments[k]->GetLastSolution(),
+						is_solved ? measurements[k].metrics(measurements[k].metrics_size() - 1) : Metrics::Metrics()
+					);
+				}
+			}
+
+			if (!schedule_writers.empty() && environments[k]->GetLastSolution()) {
+				schedule_writers[k].Write(test.id(), *environments[k]->GetLastSolution());
+			}
+		}
+	}
+
+	if (cache) {
+		LOG(INFO) << "Solution cache: " << cache->Hits() << " hits, " << cache->Misses() << " misses";
+	}
+	LOG(INFO) << "Peak RSS: " << AllocProfile::PeakRSSBytes() / (1 << 20) << " MiB"
+		<< (AllocProfile::Enabled() ? "" : ", allocations are not counted (build with ALLOC_PROFILE)");
+
+	Metrics::BenchmarkResults results;
 
-	google::protobuf::util::MessageToJsonString(measurements, &result, options);
+	for (size_t k = 0; k < algorithms->size(); ++k) {
+		const AlgoRegistry::AlgorithmInfo& algo = *(*algorithms)[k];
 
-	LOG(INFO) << "Flushing metrics to `" << argv[3] << "`";
+		environments[k]->FinishMeasurements(&measurements[k], dataset.tests_size(), solved[k]);
+		measurements[k].set_algorithm(std::string(algo.name));
+		measurements[k].set_algorithm_version(algo.version);
+
+		std::cout << "Using algorithm: `" << algo.name << "` (v" << algo.version << ")\n";
+		LOG(INFO) << "Solved: " << measurements[k].solved() << " out of " << measurements[k].tests();
+		environments[k]->PrintMeasurements(std::cout);
+
+		for (const auto& summary : measurements[k].summaries()) {
+			std::cout << summary.name() << ": 95% CI of mean [" << summary.ci_low() << ", " << summary.ci_high() << "]\n";
+		}
+
+		*results.add_runs() = measurements[k];
+	}
+
+// ------------ Flush -----------------
+
+	LOG(INFO) << "Flushing metrics to `" << args[2] << "`";
+	if (results.runs_size() == 1) {
+		DumpMetricsSet(results.runs(0), args[2]);
+	} else {
+		DumpBenchmarkResults(results, args[2]);
+	}
 
-	std::ofstream fout(argv[3], std::ios::binary | std::ios::trunc | std::ios::out);
-	fout << result;
-	
 	return 0;
-}
\ No newline at end of file
+}
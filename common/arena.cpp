@@ -0,0 +1,113 @@
+#include "arena.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+#ifdef ARENA_HUGE_PAGES
+#include <sys/mman.h>
+#endif
+
+constexpr size_t kMinChunkSize = size_t{1} << 16;
+
+#ifdef ARENA_HUGE_PAGES
+constexpr size_t kHugePageSize = size_t{1} << 21;
+#endif
+
+std::pmr::memory_resource* SolveArena::Resource() {
+	return &pool_;
+}
+
+void SolveArena::Reset() {
+	pool_.release();
+	block_.Reset();
+}
+
+size_t SolveArena::Capacity() const {
+	return block_.Capacity();
+}
+
+size_t SolveArena::HeapAllocations() const {
+	return block_.HeapAllocations();
+}
+
+SolveArena::MonotonicBlock::~MonotonicBlock() {
+	for (const auto& chunk : chunks_) {
+		FreeChunk(chunk);
+	}
+}
+
+void SolveArena::MonotonicBlock::Reset() {
+	if (chunks_.size() > 1) {
+		size_t total = 0;
+		for (const auto& chunk : chunks_) {
+			total += chunk.size;
+			FreeChunk(chunk);
+		}
+
+		chunks_.clear();
+		chunks_.push_back(AllocateChunk(total + total / 4));
+		++heap_allocations_;
+	}
+
+	current_ = 0;
+	offset_ = 0;
+}
+
+size_t SolveArena::MonotonicBlock::Capacity() const {
+	return chunks_.empty() ? 0 : chunks_[0].size;
+}
+
+size_t SolveArena::MonotonicBlock::HeapAllocations() const {
+	return heap_allocations_;
+}
+
+void* SolveArena::MonotonicBlock::do_allocate(size_t bytes, size_t alignment) {
+	while (current_ < chunks_.size()) {
+		Chunk& chunk = chunks_[current_];
+		uintptr_t base = reinterpret_cast<uintptr_t>(chunk.data);
+		size_t aligned = ((base + offset_ + alignment - 1) & ~(alignment - 1)) - base;
+
+		if (aligned + bytes <= chunk.size) {
+			offset_ = aligned + bytes;
+			return chunk.data + aligned;
+		}
+
+		++current_;
+		offset_ = 0;
+	}
+
+	size_t size = std::max({kMinChunkSize, 2 * (bytes + alignment), chunks_.empty() ? 0 : chunks_.back().size});
+	chunks_.push_back(AllocateChunk(size));
+	++heap_allocations_;
+
+	return do_allocate(bytes, alignment);
+}
+
+bool SolveArena::MonotonicBlock::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+	return this == &other;
+}
+
+SolveArena::MonotonicBlock::Chunk SolveArena::MonotonicBlock::AllocateChunk(size_t size) {
+#ifdef ARENA_HUGE_PAGES
+	size = (size + kHugePageSize - 1) / kHugePageSize * kHugePageSize;
+	void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+	if (data == MAP_FAILED) {
+		throw std::bad_alloc();
+	}
+
+	madvise(data, size, MADV_HUGEPAGE);
+	return {static_cast<std::byte*>(data), size};
+#else
+	return {static_cast<std::byte*>(::operator new(size, std::align_val_t{alignof(std::max_align_t)})), size};
+#endif
+}
+
+void SolveArena::MonotonicBlock::FreeChunk(const Chunk& chunk) {
+#ifdef ARENA_HUGE_PAGES
+	munmap(chunk.data, chunk.size);
+#else
+	::operator delete(chunk.data, std::align_val_t{alignof(std::max_align_t)});
+#endif
+}
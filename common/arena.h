@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+class SolveArena {
+	/*
+		Memory for node containers (std::pmr::set/map) of one solve. Nodes come from a pool, so
+		erased nodes are reused within a solve; the pool takes memory from a monotonic block and
+		Reset() drops everything at once. Chunks taken from the heap when the block overflows are
+		merged into one block of the peak size on the next Reset(), so in a steady state solves do
+		not touch the heap. Built with ARENA_HUGE_PAGES the block is mmap'ed and advised to use
+		transparent huge pages.
+		Containers using the arena must be emptied (or destroyed) before Reset(). A struct holding
+		both declares the arena before the containers, so that it is destroyed after them.
+	*/
+public:
+	SolveArena() = default;
+
+	SolveArena(const SolveArena&) = delete;
+	SolveArena& operator=(const SolveArena&) = delete;
+
+	std::pmr::memory_resource* Resource();
+	void Reset();
+
+	size_t Capacity() const; // bytes available without going to the heap
+	size_t HeapAllocations() const; // blocks requested from the heap so far
+
+private:
+	class MonotonicBlock final : public std::pmr::memory_resource {
+	public:
+		MonotonicBlock() = default;
+		~MonotonicBlock() override;
+
+		void Reset();
+
+		size_t Capacity() const;
+		size_t HeapAllocations() const;
+
+	private:
+		void* do_allocate(size_t bytes, size_t alignment) override;
+		void do_deallocate(void*, size_t, size_t) override {}
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+		struct Chunk {
+			std::byte* data;
+			size_t size;
+		};
+
+		static Chunk AllocateChunk(size_t size);
+		static void FreeChunk(const Chunk& chunk);
+
+	private:
+		std::vector<Chunk> chunks_; // chunks_[0] is the main block
+		size_t current_ = 0; // chunk being filled
+		size_t offset_ = 0; // inside current chunk
+		size_t heap_allocations_ = 0;
+	};
+
+private:
+	MonotonicBlock block_;
+	std::pmr::unsynchronized_pool_resource pool_{&block_};
+};
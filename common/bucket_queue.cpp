@@ -0,0 +1,106 @@
+#include "bucket_queue.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <span>
+
+void MemoryBucketQueue::Reset(const VMTable& vms) {
+	size_t count = vms.Size();
+	std::span<const uint32_t> mem = vms.Column(kMem);
+
+	slot_vm_.resize(count);
+	for (size_t i = 0; i < count; ++i) {
+		slot_vm_[i] = i;
+	}
+
+	// LSD radix sort by inverted memory: stable, so ids stay ascending inside a bucket
+	sort_buffer_.resize(count);
+	for (size_t shift = 0; shift < 32; shift += 8) {
+		std::array<size_t, 257> offsets{};
+		for (uint32_t vm_id : slot_vm_) {
+			++offsets[(~mem[vm_id] >> shift & 0xff) + 1];
+		}
+
+		if (std::find(offsets.begin(), offsets.end(), count) != offsets.end()) {
+			continue; // all VMs share this byte
+		}
+
+		for (size_t digit = 0; digit < 256; ++digit) {
+			offsets[digit + 1] += offsets[digit];
+		}
+		for (uint32_t vm_id : slot_vm_) {
+			sort_buffer_[offsets[~mem[vm_id] >> shift & 0xff]++] = vm_id;
+		}
+		slot_vm_.swap(sort_buffer_);
+	}
+
+	vm_slot_.resize(count);
+	for (size_t slot = 0; slot < count; ++slot) {
+		vm_slot_[slot_vm_[slot]] = slot;
+	}
+
+	ResizeBitmaps();
+}
+
+void MemoryBucketQueue::Reset(const MemoryBucketQueue& layout) {
+	slot_vm_ = layout.slot_vm_;
+	vm_slot_ = layout.vm_slot_;
+	ResizeBitmaps();
+}
+
+void MemoryBucketQueue::ResizeBitmaps() {
+	words_.resize((slot_vm_.size() + 63) / 64);
+	summary_.resize((words_.size() + 63) / 64);
+	Clear();
+}
+
+void MemoryBucketQueue::Clear() {
+	std::fill(words_.begin(), words_.end(), 0);
+	std::fill(summary_.begin(), summary_.end(), 0);
+	size_ = 0;
+}
+
+size_t MemoryBucketQueue::Front() const {
+	size_t slot = NextSlot(0);
+	return slot == kNone ? kNone : slot_vm_[slot];
+}
+
+size_t MemoryBucketQueue::Back() const {
+	for (size_t i = summary_.size(); i-- > 0;) {
+		if (summary_[i]) {
+			size_t word = i * 64 + 63 - std::countl_zero(summary_[i]);
+			return slot_vm_[word * 64 + 63 - std::countl_zero(words_[word])];
+		}
+	}
+
+	return kNone;
+}
+
+size_t MemoryBucketQueue::NextSlot(size_t slot) const {
+	size_t word = slot / 64;
+	if (word >= words_.size()) {
+		return kNone;
+	}
+
+	uint64_t rest = words_[word] & (~uint64_t{0} << (slot % 64));
+	if (rest) {
+		return word * 64 + std::countr_zero(rest);
+	}
+
+	// next non-empty word from the summary
+	++word;
+	for (size_t i = word / 64; i < summary_.size(); ++i) {
+		uint64_t mask = summary_[i];
+		if (i == word / 64) {
+			mask &= ~uint64_t{0} << (word % 64);
+		}
+
+		if (mask) {
+			size_t next = i * 64 + std::countr_zero(mask);
+			return next * 64 + std::countr_zero(words_[next]);
+		}
+	}
+
+	return kNone;
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+#include "solution.h"
+
+class MemoryBucketQueue {
+	/*
+		Set of VM ids in the order of (mem desc, id asc). VMs with equal memory form a bucket;
+		generated problems have only a handful of memory classes. Reset() lays buckets out in
+		one slot range (largest memory first, ids ascending inside a bucket) with a radix sort
+		in O(n), a queue over the same VMs copies the layout instead. Membership is one bit per
+		slot and a two-level bitmap finds the first/last present slot.
+		Insert, Erase and Contains are O(1); Front, Back and iteration skip 64 slots per word.
+	*/
+public:
+	static constexpr size_t kNone = SIZE_MAX;
+
+	void Reset(const VMTable& vms); // lays out buckets for these VMs, queue is empty
+	void Reset(const MemoryBucketQueue& layout); // same layout as another queue, queue is empty
+	void Clear();
+
+	void Insert(size_t vm_id) {
+		size_t slot = vm_slot_[vm_id];
+		uint64_t bit = uint64_t{1} << (slot % 64);
+
+		if (!(words_[slot / 64] & bit)) {
+			words_[slot / 64] |= bit;
+			summary_[slot / 4096] |= uint64_t{1} << (slot / 64 % 64);
+			++size_;
+		}
+	}
+
+	void Erase(size_t vm_id) {
+		size_t slot = vm_slot_[vm_id];
+		uint64_t bit = uint64_t{1} << (slot % 64);
+
+		if (words_[slot / 64] & bit) {
+			words_[slot / 64] ^= bit;
+			if (!words_[slot / 64]) {
+				summary_[slot / 4096] &= ~(uint64_t{1} << (slot / 64 % 64));
+			}
+			--size_;
+		}
+	}
+
+	bool Contains(size_t vm_id) const {
+		size_t slot = vm_slot_[vm_id];
+		return words_[slot / 64] >> (slot % 64) & 1;
+	}
+
+	bool Empty() const { return !size_; }
+	size_t Size() const { return size_; }
+
+	size_t Front() const; // largest memory, smallest id; kNone if empty
+	size_t Back() const; // smallest memory, largest id; kNone if empty
+
+	class Iterator {
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = size_t;
+		using difference_type = std::ptrdiff_t;
+
+		Iterator() = default;
+		Iterator(const MemoryBucketQueue* queue, size_t slot) : queue_(queue), slot_(slot) {}
+
+		size_t operator*() const { return queue_->slot_vm_[slot_]; }
+		Iterator& operator++() {
+			slot_ = queue_->NextSlot(slot_ + 1);
+			return *this;
+		}
+		Iterator operator++(int) {
+			Iterator prev = *this;
+			++*this;
+			return prev;
+		}
+		bool operator==(const Iterator& other) const { return slot_ == other.slot_; }
+
+	private:
+		const MemoryBucketQueue* queue_ = nullptr;
+		size_t slot_ = kNone;
+	};
+
+	Iterator begin() const { return Iterator(this, NextSlot(0)); }
+	Iterator end() const { return Iterator(this, kNone); }
+
+private:
+	size_t NextSlot(size_t slot) const; // first present slot >= `slot`, kNone if none
+	void ResizeBitmaps();
+
+	std::vector<uint32_t> vm_slot_;
+	std::vector<uint32_t> slot_vm_;
+	std::vector<uint32_t> sort_buffer_;
+	std::vector<uint64_t> words_; // bit per slot
+	std::vector<uint64_t> summary_; // bit per non-empty word
+	size_t size_ = 0;
+};
@@ -0,0 +1,95 @@
+#include "cycle_breaker.h"
+
+#include <algorithm>
+
+void CycleBreaker::Reset(size_t servers_cnt, size_t pods_cnt) {
+	waits_for_.assign(servers_cnt, kNone);
+	walk_.assign(servers_cnt, 0);
+	on_cycle_.assign((servers_cnt + 63) / 64, 0);
+	out_free_.assign(servers_cnt, 0);
+	in_free_.assign(servers_cnt, 0);
+	uplink_free_.assign(pods_cnt, 0);
+	targets_.clear();
+	group_end_ = 0;
+}
+
+const std::vector<size_t>& CycleBreaker::FindCycles(
+	const Problem& problem,
+	const std::vector<size_t>& vm_pos,
+	const MemoryBucketQueue& misplaced_vms
+) {
+	size_t servers_cnt = problem.server_specs.size();
+	Reset(servers_cnt, problem.topology.PodsCount());
+
+	// the queue goes from the largest VM, so the smallest one of a server is written last
+	for (size_t vm_id : misplaced_vms) {
+		waits_for_[vm_pos[vm_id]] = vm_id;
+	}
+
+	auto next = [&](size_t server) {
+		return problem.end_position.vm_server[waits_for_[server]];
+	};
+
+	for (size_t start = 0; start < servers_cnt; ++start) {
+		size_t server = start;
+		while (waits_for_[server] != kNone && !walk_[server]) {
+			walk_[server] = start + 1;
+			server = next(server);
+		}
+
+		// a cycle is new only if the walk ran into itself
+		if (waits_for_[server] == kNone || walk_[server] != start + 1) {
+			continue;
+		}
+
+		size_t target = waits_for_[server];
+		size_t cycle_server = server;
+		do {
+			on_cycle_[cycle_server / 64] |= uint64_t{1} << (cycle_server % 64);
+			if (problem.vms.Table().Mem(waits_for_[cycle_server]) < problem.vms.Table().Mem(target)) {
+				target = waits_for_[cycle_server];
+			}
+			cycle_server = next(cycle_server);
+		} while (cycle_server != server);
+
+		targets_.push_back(target);
+	}
+
+	std::sort(targets_.begin(), targets_.end(), [&](size_t lhs, size_t rhs) {
+		if (problem.vms.Table().Mem(lhs) != problem.vms.Table().Mem(rhs)) {
+			return problem.vms.Table().Mem(lhs) < problem.vms.Table().Mem(rhs);
+		}
+		return lhs > rhs;
+	});
+
+	return targets_;
+}
+
+TimeMoment CycleBreaker::PlanEviction(const Problem& problem, size_t from, size_t to, TimeMoment start, TimeMoment duration) {
+	/*
+		Channels are taken one at a time even on servers with more of them, and a limited uplink
+		carries one eviction at a time: the group is short, a simple safe packing is enough.
+	*/
+	const Topology& topology = problem.topology;
+	bool uses_uplinks = topology.Hop(from, to) == kCrossPod;
+
+	start = std::max({start, out_free_[from], in_free_[to]});
+	if (uses_uplinks) {
+		for (size_t pod : {topology.Pod(from), topology.Pod(to)}) {
+			if (topology.UplinkLimit(pod) != 0) {
+				start = std::max(start, uplink_free_[pod]);
+			}
+		}
+	}
+
+	TimeMoment end = start + duration;
+	out_free_[from] = end;
+	in_free_[to] = end;
+	if (uses_uplinks) {
+		uplink_free_[topology.Pod(from)] = end;
+		uplink_free_[topology.Pod(to)] = end;
+	}
+	group_end_ = std::max(group_end_, end);
+
+	return start;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "bucket_queue.h"
+#include "solution.h"
+
+class CycleBreaker {
+	/*
+		In a deadlock every misplaced VM waits for room on its destination. Let every server wait
+		for the destination of its smallest misplaced VM: each server then waits for at most one
+		other, so the cycles of this graph are disjoint and all of them can be broken at once.
+		One blocked VM per cycle gets room by evicting VMs from its destination to buffers which
+		lie outside of all cycles, so evictions never take the room another cycle needs.
+		Evictions of different cycles share no source server and run as one parallel group.
+	*/
+public:
+	static constexpr size_t kNone = SIZE_MAX;
+
+	// blocked VMs, one per disjoint cycle, smallest first; starts a new group of evictions
+	const std::vector<size_t>& FindCycles(
+		const Problem& problem,
+		const std::vector<size_t>& vm_pos,
+		const MemoryBucketQueue& misplaced_vms
+	);
+
+	const std::vector<uint64_t>& CycleServers() const { return on_cycle_; } // bit per server
+	bool OnCycle(size_t server) const { return on_cycle_[server / 64] >> (server % 64) & 1; }
+
+	// earliest moment from `start` when the group leaves channels and uplinks for this move, reserves them
+	TimeMoment PlanEviction(const Problem& problem, size_t from, size_t to, TimeMoment start, TimeMoment duration);
+	TimeMoment GroupEnd() const { return group_end_; } // 0 if nothing is planned
+
+private:
+	void Reset(size_t servers_cnt, size_t pods_cnt);
+
+private:
+	std::vector<size_t> waits_for_; // server -> its smallest misplaced VM, kNone if none
+	std::vector<size_t> walk_; // server -> walk which visited it, 0 if none
+	std::vector<size_t> targets_;
+	std::vector<uint64_t> on_cycle_;
+	std::vector<TimeMoment> out_free_; // per server, when the group releases its channels
+	std::vector<TimeMoment> in_free_;
+	std::vector<TimeMoment> uplink_free_; // per pod
+	TimeMoment group_end_ = 0;
+};
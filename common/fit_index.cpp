@@ -0,0 +1,73 @@
+#include "fit_index.h"
+
+#include <algorithm>
+#include <bit>
+
+void FitIndex::Reset(const Problem& problem, const std::vector<Server>& servers) {
+	servers_ = &servers;
+
+	server_free_.Resize(servers.size());
+	for (size_t i = 0; i < servers.size(); ++i) {
+		UpdateServer(i);
+	}
+
+	// counting sort of VMs by destination keeps ids ascending inside a group
+	incoming_offsets_.assign(servers.size() + 1, 0);
+	for (size_t server_id : problem.end_position.vm_server) {
+		++incoming_offsets_[server_id + 1];
+	}
+	for (size_t i = 0; i < servers.size(); ++i) {
+		incoming_offsets_[i + 1] += incoming_offsets_[i];
+	}
+
+	const VMTable& vms = problem.vms.Table();
+	incoming_vms_.resize(vms.Size());
+	vm_demand_.Resize(vms.Size());
+
+	fill_.assign(incoming_offsets_.begin(), incoming_offsets_.end() - 1);
+
+	for (size_t vm_id = 0; vm_id < vms.Size(); ++vm_id) {
+		size_t row = fill_[problem.end_position.vm_server[vm_id]]++;
+		incoming_vms_[row] = vm_id;
+		vm_demand_.Set(row, vms.Demand(vm_id));
+	}
+}
+
+void FitIndex::UpdateServer(size_t server_id) {
+	server_free_.Set(server_id, (*servers_)[server_id].GetFreeResources());
+}
+
+size_t FitIndex::FindHost(const VM& vm, size_t start, size_t exclude) {
+	static const std::vector<uint64_t> kNothing;
+	return FindHost(vm, start, exclude, kNothing);
+}
+
+size_t FitIndex::FindHost(const VM& vm, size_t start, size_t exclude, const std::vector<uint64_t>& excluded) {
+	size_t servers_cnt = server_free_.Rows();
+	server_free_.Match(Demand(vm), FitDirection::kAtLeast, 0, servers_cnt, &mask_);
+
+	if (exclude < servers_cnt) {
+		mask_[exclude / 64] &= ~(uint64_t{1} << (exclude % 64));
+	}
+	for (size_t word = 0; word < std::min(excluded.size(), mask_.size()); ++word) {
+		mask_[word] &= ~excluded[word];
+	}
+
+	auto first_from = [&](size_t from, size_t to) -> size_t {
+		for (size_t word = from / 64; word * 64 < to; ++word) {
+			uint64_t bits = mask_[word];
+			if (word == from / 64) {
+				bits &= ~uint64_t{0} << (from % 64);
+			}
+
+			if (bits) {
+				size_t server_id = word * 64 + std::countr_zero(bits);
+				return server_id < to ? server_id : kNone;
+			}
+		}
+		return kNone;
+	};
+
+	size_t result = first_from(start, servers_cnt);
+	return result != kNone ? result : first_from(0, start);
+}
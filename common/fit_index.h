@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vector>
+
+#include "resources.h"
+#include "solution.h"
+
+class FitIndex {
+	/*
+		Mirrors free resources of servers and demands of VMs grouped by their destination server
+		in ResourceTables, so "which servers can host this VM" and "which VMs heading to this
+		server fit into it now" are one batch FitMask call instead of a loop of Server::CanFit.
+		UpdateServer must be called after every change of a server's free resources.
+	*/
+public:
+	static constexpr size_t kNone = SIZE_MAX;
+
+	void Reset(const Problem& problem, const std::vector<Server>& servers);
+	void UpdateServer(size_t server_id);
+
+	// first server able to host `vm` in cyclic order from `start`, skipping `exclude`; kNone if none
+	size_t FindHost(const VM& vm, size_t start, size_t exclude);
+	// same, also skipping servers set in the bitmap `excluded` (bit per server)
+	size_t FindHost(const VM& vm, size_t start, size_t exclude, const std::vector<uint64_t>& excluded);
+
+	// calls f(vm_id, fits) for every VM whose destination is `server_id`, ids ascending
+	template<class F>
+	void ForEachIncoming(size_t server_id, F f) {
+		size_t begin = incoming_offsets_[server_id];
+		size_t end = incoming_offsets_[server_id + 1];
+
+		vm_demand_.Match((*servers_)[server_id].GetFreeResources(), FitDirection::kAtMost, begin, end, &mask_);
+
+		for (size_t i = begin; i < end; ++i) {
+			f(incoming_vms_[i], static_cast<bool>(mask_[(i - begin) / 64] >> ((i - begin) % 64) & 1));
+		}
+	}
+
+private:
+	const std::vector<Server>* servers_ = nullptr;
+	ResourceTable<kResourceKinds> server_free_;
+	ResourceTable<kResourceKinds> vm_demand_; // rows follow incoming_vms_
+	std::vector<size_t> incoming_offsets_; // VMs heading to server s are [incoming_offsets_[s], incoming_offsets_[s + 1])
+	std::vector<size_t> incoming_vms_;
+	std::vector<size_t> fill_; // next free row of each group while building
+	std::vector<uint64_t> mask_;
+};
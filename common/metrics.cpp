@@ -1,66 +1,156 @@
 #include "metrics.h"
 
 #include <algorithm>
+#include <cmath>
 
-long double TotalTime::Evaluate(const Problem&, const Solution& solution) {
-	long double result = 0;
-
-	for (const auto& movements : solution.vm_movements) {
-		for (const auto& movement : movements) {
-			result = std::max(result, movement.start_moment + movement.duration);
+std::array<long double, 2> PeakTransfers::Finish(const Problem&) {
+	// transfer ending at moment T does not intersect with transfer starting at T
+	std::sort(events_.begin(), events_.end(), [](const Event& lhs, const Event& rhs) {
+		if (lhs.moment != rhs.moment) {
+			return lhs.moment < rhs.moment;
+		}
+		return lhs.is_start < rhs.is_start;
+	});
+
+	size_t current = 0, current_mem = 0;
+	size_t result = 0, result_mem = 0;
+
+	for (const auto& event : events_) {
+		if (event.is_start) {
+			++current;
+			current_mem += event.mem;
+			result = std::max(result, current);
+			result_mem = std::max(result_mem, current_mem);
+		} else {
+			--current;
+			current_mem -= event.mem;
 		}
 	}
 
-	return result;
+	return {static_cast<long double>(result), static_cast<long double>(result_mem)};
 }
 
-long double SumMigrationTime::Evaluate(const Problem&, const Solution& solution) {
-	long double result = 0;
+void ChannelUtilization::Start(const Problem& task) {
+	busy_.assign(task.server_specs.size(), 0);
+	makespan_ = 0;
+}
 
-	for (const auto& movements : solution.vm_movements) {
-		for (const auto& movement : movements) {
-			result += movement.duration;
+std::vector<long double> ChannelUtilization::Utilizations(const Problem& task) const {
+	std::vector<long double> result;
+
+	if (makespan_ == 0) {
+		return result;
+	}
+
+	for (size_t i = 0; i < busy_.size(); ++i) {
+		if (busy_[i] == 0) {
+			continue;
 		}
+
+		size_t channels = task.server_specs[i].max_in + task.server_specs[i].max_out;
+		result.push_back(TimeToUnits(busy_[i]) / (TimeToUnits(makespan_) * channels));
 	}
 
 	return result;
 }
 
-long double TotalMemoryMigration::Evaluate(const Problem& task, const Solution& solution) {
+long double MeanChannelUtilization::Finish(const Problem& task) {
+	std::vector<long double> utilizations = Utilizations(task);
+
+	if (utilizations.empty()) {
+		return 0;
+	}
+
 	long double result = 0;
+	for (auto val : utilizations) {
+		result += val;
+	}
 
-	for (const auto& movements : solution.vm_movements) {
-		for (const auto& movement : movements) {
-			result += task.vms[movement.vm_id].mem;
-		}
+	return result / utilizations.size();
+}
+
+long double MaxChannelUtilization::Finish(const Problem& task) {
+	std::vector<long double> utilizations = Utilizations(task);
+
+	if (utilizations.empty()) {
+		return 0;
 	}
 
-	return result;
+	return *std::max_element(utilizations.begin(), utilizations.end());
 }
 
-long double TotalSteps::Evaluate(const Problem& task, const Solution& solution) {
-	long double result = 0;
+std::array<long double, 3> CompletionMetrics::Finish(const Problem& task) {
+	long double weighted = 0, lateness = 0;
+	size_t misses = 0;
 
-	for (const auto& movements : solution.vm_movements) {
-		result += movements.size();
+	for (const auto& vm : task.vms) {
+		TimeMoment completion = completion_[vm.id];
+		weighted += vm.priority * TimeToUnits(completion);
+
+		if (completion > vm.deadline) {
+			++misses;
+			lateness += TimeToUnits(completion - vm.deadline);
+		}
 	}
 
-	return result;
+	return {weighted, static_cast<long double>(misses), lateness};
 }
 
 MetricsAccumulator::MetricsAccumulator(std::string_view name)
 	: metric_name_(name) {}
 
 void MetricsAccumulator::Clear() {
-	measurements_.clear();
+	count_ = 0;
+	mean_ = 0;
+	m2_ = 0;
+	min_ = 0;
+	max_ = 0;
+	sketch_.Clear();
 }
 
 void MetricsAccumulator::AppendMetric(long double val) {
-	measurements_.push_back(val);
+	min_ = count_ ? std::min(min_, val) : val;
+	max_ = count_ ? std::max(max_, val) : val;
+
+	++count_;
+	long double delta = val - mean_;
+	mean_ += delta / count_;
+	m2_ += delta * (val - mean_);
+
+	sketch_.Add(val);
+}
+
+void MetricsAccumulator::Merge(const MetricsAccumulator& other) {
+	if (!other.count_) {
+		return;
+	}
+
+	if (!count_) {
+		// keeps own name: only statistics are taken from other
+		count_ = other.count_;
+		mean_ = other.mean_;
+		m2_ = other.m2_;
+		min_ = other.min_;
+		max_ = other.max_;
+		sketch_ = other.sketch_;
+		return;
+	}
+
+	// Chan et al. parallel variance
+	size_t total = count_ + other.count_;
+	long double delta = other.mean_ - mean_;
+
+	mean_ += delta * other.count_ / total;
+	m2_ += other.m2_ + delta * delta * count_ * other.count_ / total;
+	min_ = std::min(min_, other.min_);
+	max_ = std::max(max_, other.max_);
+	count_ = total;
+
+	sketch_.Merge(other.sketch_);
 }
 
 size_t MetricsAccumulator::TotalCount() const {
-	return measurements_.size();
+	return count_;
 }
 
 std::string MetricsAccumulator::GetName() const {
@@ -68,12 +158,33 @@ std::string MetricsAccumulator::GetName() const {
 }
 
 long double MetricsAccumulator::GetMean() const {
-	long double res = 0;
-	long double divisor = TotalCount();
+	return mean_;
+}
+
+long double MetricsAccumulator::GetVariance() const {
+	return count_ > 1 ? m2_ / (count_ - 1) : 0;
+}
+
+long double MetricsAccumulator::GetStdDev() const {
+	return std::sqrt(GetVariance());
+}
+
+long double MetricsAccumulator::GetMin() const {
+	return min_;
+}
+
+long double MetricsAccumulator::GetMax() const {
+	return max_;
+}
+
+long double MetricsAccumulator::GetQuantile(double q) const {
+	if (!count_) {
+		return 0;
+	}
 
-	for (long double val : measurements_) {
-		res += val / divisor;
+	if (q >= 1) {
+		return max_;
 	}
 
-	return res;
+	return std::clamp<long double>(sketch_.Quantile(q), min_, max_);
 }
@@ -1,48 +1,274 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+
+#include "quantile_sketch.h"
 #include "solution.h"
 
-class IMetric {
+/*
+	Metric is a class with
+		static constexpr std::string_view kName;
+		void Start(const Problem& task);                    // before the pass
+		void Visit(const Problem& task, const Movement& move); // once per movement
+		long double Finish(const Problem& task);            // value in time units, see TimeToUnits
+	Metrics sharing their state are one class with
+		static constexpr std::array<std::string_view, N> kNames;
+		std::array<long double, N> Finish(const Problem& task);
+	MetricsEngine picks metrics at compile time and evaluates all of them in a single pass
+	over Solution's movements, so Visit calls of different metrics are fused into one loop.
+*/
+
+namespace MetricsEngineDetail {
+
+	template<class Metric>
+	constexpr auto Names() {
+		if constexpr (requires { Metric::kNames; }) {
+			return Metric::kNames;
+		} else {
+			return std::array<std::string_view, 1>{Metric::kName};
+		}
+	}
+
+	template<class Metric>
+	auto Finish(Metric& metric, const Problem& task) {
+		if constexpr (requires { Metric::kNames; }) {
+			return metric.Finish(task);
+		} else {
+			return std::array<long double, 1>{metric.Finish(task)};
+		}
+	}
+
+	template<class T, size_t... Sizes>
+	constexpr auto Concat(const std::array<T, Sizes>&... parts) {
+		std::array<T, (Sizes + ...)> result{};
+		size_t pos = 0;
+		((std::copy(parts.begin(), parts.end(), result.begin() + pos), pos += parts.size()), ...);
+		return result;
+	}
+
+}
+
+template<class... Metrics>
+class MetricsEngine {
+public:
+	static constexpr auto kNames = MetricsEngineDetail::Concat(MetricsEngineDetail::Names<Metrics>()...);
+	static constexpr size_t kMetricsCount = kNames.size();
+
+	using Values = std::array<long double, kMetricsCount>;
+
+	static Values Evaluate(const Problem& task, const Solution& solution) {
+		std::tuple<Metrics...> metrics;
+
+		return std::apply([&](auto&... metric) -> Values {
+			(metric.Start(task), ...);
+
+			for (const auto& move : solution.GetMovements()) {
+				(metric.Visit(task, move), ...);
+			}
+
+			return MetricsEngineDetail::Concat(MetricsEngineDetail::Finish(metric, task)...);
+		}, metrics);
+	}
+};
+
+
+class TotalTime {
+public:
+	static constexpr std::string_view kName = "TotalTime";
+
+	void Start(const Problem&) {}
+	void Visit(const Problem&, const Movement& move) {
+		result_ = std::max(result_, move.start_moment + move.duration);
+	}
+	long double Finish(const Problem&) { return TimeToUnits(result_); }
+
+private:
+	TimeMoment result_ = 0;
+};
+
+
+class SumMigrationTime {
+public:
+	static constexpr std::string_view kName = "SumMigrationTime";
+
+	void Start(const Problem&) {}
+	void Visit(const Problem&, const Movement& move) { result_ += move.duration; }
+	long double Finish(const Problem&) { return TimeToUnits(result_); }
+
+private:
+	TimeMoment result_ = 0;
+};
+
+
+class TotalMemoryMigration {
+public:
+	static constexpr std::string_view kName = "TotalMemoryMigration";
+
+	void Start(const Problem&) {}
+	void Visit(const Problem& task, const Movement& move) { result_ += task.vms[move.vm_id].mem; }
+	long double Finish(const Problem&) { return result_; }
+
+private:
+	size_t result_ = 0;
+};
+
+
+class TotalSteps {
+public:
+	static constexpr std::string_view kName = "TotalSteps";
+
+	void Start(const Problem&) {}
+	void Visit(const Problem&, const Movement&) { ++result_; }
+	long double Finish(const Problem&) { return result_; }
+
+private:
+	size_t result_ = 0;
+};
+
+
+class BufferHops { // movements which do not end on VM's final server
+public:
+	static constexpr std::string_view kName = "BufferHops";
+
+	void Start(const Problem&) {}
+	void Visit(const Problem& task, const Movement& move) {
+		result_ += move.to != task.end_position.vm_server[move.vm_id];
+	}
+	long double Finish(const Problem&) { return result_; }
+
+private:
+	size_t result_ = 0;
+};
+
+
+class PeakTransfers {
+	// collects starts and ends of transfers, Finish sweeps them in time order once for both peaks
 public:
-	virtual long double Evaluate(const Problem& task, const Solution& solution) = 0;
+	static constexpr std::array<std::string_view, 2> kNames = {"PeakConcurrentMigrations", "PeakMemoryInFlight"};
+
+	void Start(const Problem&) { events_.clear(); }
+	void Visit(const Problem& task, const Movement& move) {
+		size_t mem = task.vms[move.vm_id].mem;
+		events_.push_back({move.start_moment, mem, true});
+		events_.push_back({move.start_moment + move.duration, mem, false});
+	}
+	std::array<long double, 2> Finish(const Problem& task); // maximal count and memory of simultaneous transfers
+
+private:
+	struct Event {
+		TimeMoment moment;
+		size_t mem;
+		bool is_start;
+	};
+
+	std::vector<Event> events_;
 };
 
 
-class TotalTime final : public IMetric {
+class ChannelUtilization {
+	/*
+		Utilization of a server is the busy time of its upload and download channels divided by
+		(max_out + max_in) * TotalTime. Only servers taking part in migrations are considered.
+	*/
 public:
-	long double Evaluate(const Problem& task, const Solution& solution) override;
+	void Start(const Problem& task);
+	void Visit(const Problem&, const Movement& move) {
+		busy_[move.from] += move.duration;
+		busy_[move.to] += move.duration;
+		makespan_ = std::max(makespan_, move.start_moment + move.duration);
+	}
+
+protected:
+	std::vector<long double> Utilizations(const Problem& task) const;
+
+private:
+	std::vector<TimeMoment> busy_;
+	TimeMoment makespan_ = 0;
 };
 
 
-class SumMigrationTime final : public IMetric {
+class MeanChannelUtilization : public ChannelUtilization {
 public:
-	long double Evaluate(const Problem& task, const Solution& solution) override;
+	static constexpr std::string_view kName = "MeanChannelUtilization";
+
+	long double Finish(const Problem& task);
 };
 
 
-class TotalMemoryMigration final : public IMetric {
+class MaxChannelUtilization : public ChannelUtilization {
 public:
-	long double Evaluate(const Problem& task, const Solution& solution) override;
+	static constexpr std::string_view kName = "MaxChannelUtilization";
+
+	long double Finish(const Problem& task);
 };
 
-class TotalSteps final : public IMetric {
+
+class CompletionMetrics {
+	/*
+		Moment every VM reaches its last server (0 for VMs which do not move), kept once for
+		WeightedCompletionTime (sum of priority * completion), DeadlineMisses and TotalLateness
+		(sum of completion - deadline over late VMs).
+	*/
 public:
-	long double Evaluate(const Problem& task, const Solution& solution) override;
+	static constexpr std::array<std::string_view, 3> kNames = {"WeightedCompletionTime", "DeadlineMisses", "TotalLateness"};
+
+	void Start(const Problem& task) { completion_.assign(task.vms.size(), 0); }
+	void Visit(const Problem&, const Movement& move) {
+		completion_[move.vm_id] = std::max(completion_[move.vm_id], move.start_moment + move.duration);
+	}
+	std::array<long double, 3> Finish(const Problem& task);
+
+private:
+	std::vector<TimeMoment> completion_;
 };
 
+
+using PlanMetrics = MetricsEngine<
+	TotalTime,
+	TotalMemoryMigration,
+	SumMigrationTime,
+	TotalSteps,
+	PeakTransfers,
+	MeanChannelUtilization,
+	MaxChannelUtilization,
+	BufferHops,
+	CompletionMetrics
+>;
+
+
 class MetricsAccumulator {
+	/*
+		Streaming statistics in constant memory: Welford mean/variance, exact min/max and
+		a quantile sketch. Accumulators of the same metric can be merged (threads, shards).
+	*/
 public:
 	MetricsAccumulator(std::string_view name);
 
 	void Clear();
 	void AppendMetric(long double val);
+	void Merge(const MetricsAccumulator& other);
 
 	long double GetMean() const;
+	long double GetVariance() const; // sample variance
+	long double GetStdDev() const;
+	long double GetMin() const;
+	long double GetMax() const;
+	long double GetQuantile(double q) const; // approximate, q in [0, 1]
 	std::string GetName() const;
 
 	size_t TotalCount() const;
 
 private:
 	std::string metric_name_;
-	std::vector<long double> measurements_;
-};
\ No newline at end of file
+	size_t count_ = 0;
+	long double mean_ = 0;
+	long double m2_ = 0; // sum of squared deviations from mean
+	long double min_ = 0;
+	long double max_ = 0;
+	QuantileSketch sketch_;
+};
@@ -0,0 +1,14 @@
+#include "plan_stream.h"
+
+std::optional<Solution> CollectPlan(PlanStream&& stream, size_t vms_count, SolutionBuilder* builder) {
+	builder->Reset(vms_count);
+
+	while (stream.Next()) {
+		builder->AddMovement(stream.Value());
+	}
+
+	if (!stream.Solved()) {
+		return std::nullopt;
+	}
+	return builder->Build();
+}
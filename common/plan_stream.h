@@ -0,0 +1,74 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+#include "solution.h"
+
+class PlanStream {
+	/*
+		Movements of a plan produced lazily by a solver coroutine, start moments never decrease.
+		A movement is final once emitted, so an executor can start it while the solver goes on.
+		The solver runs only inside Next() and stays suspended otherwise: a consumer with no free
+		channels just does not ask for more, and the solver does no work ahead of it.
+		The solver co_returns whether the plan is complete. An incomplete stream ends early, its
+		movements are valid on their own but do not reach the end arrangement.
+		The problem and the workspace the solver was started with must outlive the stream, and a
+		workspace serves one live stream of a solver at a time.
+	*/
+public:
+	struct promise_type {
+		Movement current{};
+		bool solved = false;
+		std::exception_ptr exception;
+
+		PlanStream get_return_object() { return PlanStream(std::coroutine_handle<promise_type>::from_promise(*this)); }
+		std::suspend_always initial_suspend() noexcept { return {}; }
+		std::suspend_always final_suspend() noexcept { return {}; }
+		std::suspend_always yield_value(const Movement& move) noexcept {
+			current = move;
+			return {};
+		}
+		void return_value(bool complete) noexcept { solved = complete; }
+		void unhandled_exception() { exception = std::current_exception(); }
+	};
+
+	PlanStream() = default;
+	PlanStream(PlanStream&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+	PlanStream& operator=(PlanStream&& other) noexcept {
+		std::swap(handle_, other.handle_);
+		return *this;
+	}
+	~PlanStream() {
+		if (handle_) {
+			handle_.destroy();
+		}
+	}
+
+	// runs the solver up to its next movement, false once the stream ended; rethrows solver's exceptions
+	bool Next() {
+		if (!handle_ || handle_.done()) {
+			return false;
+		}
+
+		handle_.resume();
+		if (handle_.promise().exception) {
+			std::rethrow_exception(std::exchange(handle_.promise().exception, nullptr));
+		}
+		return !handle_.done();
+	}
+
+	const Movement& Value() const { return handle_.promise().current; } // of the last successful Next()
+	bool Solved() const { return handle_ && handle_.done() && handle_.promise().solved; } // the ended plan is complete
+
+private:
+	explicit PlanStream(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+private:
+	std::coroutine_handle<promise_type> handle_;
+};
+
+// drains the stream into `builder`, nullopt if the plan is incomplete
+std::optional<Solution> CollectPlan(PlanStream&& stream, size_t vms_count, SolutionBuilder* builder);
@@ -0,0 +1,131 @@
+#include "quantile_sketch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+constexpr uint64_t kSketchSeed = 0x9E3779B97F4A7C15ull;
+
+QuantileSketch::QuantileSketch(size_t k)
+	: k_(std::max<size_t>(k, 8))
+	, levels_(1)
+	, random_state_(kSketchSeed)
+{
+}
+
+void QuantileSketch::Clear() {
+	count_ = 0;
+	levels_.assign(1, {});
+	random_state_ = kSketchSeed;
+}
+
+void QuantileSketch::Add(double value) {
+	levels_[0].push_back(value);
+	++count_;
+
+	if (levels_[0].size() >= LevelCapacity(0)) {
+		Compress();
+	}
+}
+
+void QuantileSketch::Merge(const QuantileSketch& other) {
+	if (levels_.size() < other.levels_.size()) {
+		levels_.resize(other.levels_.size());
+	}
+
+	for (size_t h = 0; h < other.levels_.size(); ++h) {
+		levels_[h].insert(levels_[h].end(), other.levels_[h].begin(), other.levels_[h].end());
+	}
+
+	count_ += other.count_;
+	Compress();
+}
+
+size_t QuantileSketch::Count() const {
+	return count_;
+}
+
+size_t QuantileSketch::RetainedItems() const {
+	size_t result = 0;
+	for (const auto& level : levels_) {
+		result += level.size();
+	}
+	return result;
+}
+
+double QuantileSketch::Quantile(double q) const {
+	if (count_ == 0) {
+		throw std::logic_error("Quantile of empty sketch");
+	}
+
+	std::vector<std::pair<double, uint64_t>> weighted;
+	weighted.reserve(RetainedItems());
+
+	uint64_t total_weight = 0;
+	for (size_t h = 0; h < levels_.size(); ++h) {
+		for (double value : levels_[h]) {
+			weighted.emplace_back(value, uint64_t{1} << h);
+			total_weight += uint64_t{1} << h;
+		}
+	}
+
+	std::sort(weighted.begin(), weighted.end());
+
+	long double target = std::clamp(q, 0.0, 1.0) * total_weight;
+	uint64_t cumulative = 0;
+
+	for (const auto& [value, weight] : weighted) {
+		cumulative += weight;
+		if (cumulative >= target) {
+			return value;
+		}
+	}
+
+	return weighted.back().first;
+}
+
+size_t QuantileSketch::LevelCapacity(size_t level) const {
+	size_t depth = levels_.size() - level - 1;
+	return std::max<size_t>(2, std::ceil(k_ * std::pow(2.0 / 3.0, depth)));
+}
+
+void QuantileSketch::Compress() {
+	for (size_t h = 0; h < levels_.size(); ++h) {
+		if (levels_[h].size() < LevelCapacity(h)) {
+			continue;
+		}
+
+		if (h + 1 == levels_.size()) {
+			levels_.emplace_back();
+		}
+
+		auto& level = levels_[h];
+		std::sort(level.begin(), level.end());
+
+		// odd item stays on its level, so total weight is preserved
+		double leftover = 0;
+		bool has_leftover = level.size() % 2;
+		if (has_leftover) {
+			leftover = level.back();
+			level.pop_back();
+		}
+
+		for (size_t i = RandomBit(); i < level.size(); i += 2) {
+			levels_[h + 1].push_back(level[i]);
+		}
+
+		level.clear();
+		if (has_leftover) {
+			level.push_back(leftover);
+		}
+	}
+}
+
+bool QuantileSketch::RandomBit() {
+	// xorshift64: deterministic, so runs are reproducible
+	random_state_ ^= random_state_ << 13;
+	random_state_ ^= random_state_ >> 7;
+	random_state_ ^= random_state_ << 17;
+	return random_state_ & 1;
+}
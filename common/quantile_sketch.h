@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class QuantileSketch {
+	/*
+		KLL sketch: level h keeps items of weight 2^h. When a level overflows its capacity, it is
+		sorted and every second item (random parity) is promoted to the next level. Capacities
+		decrease geometrically towards the lower levels, so memory is O(k) items regardless of
+		the number of added values, and rank error is about 1.7 / k. Sketches are mergeable.
+	*/
+public:
+	static constexpr size_t kDefaultK = 200;
+
+	explicit QuantileSketch(size_t k = kDefaultK);
+
+	void Clear();
+	void Add(double value);
+	void Merge(const QuantileSketch& other);
+
+	double Quantile(double q) const; // q in [0, 1]
+	size_t Count() const;
+	size_t RetainedItems() const;
+
+private:
+	size_t LevelCapacity(size_t level) const;
+	void Compress();
+	bool RandomBit();
+
+private:
+	size_t k_;
+	size_t count_ = 0;
+	std::vector<std::vector<double>> levels_;
+	uint64_t random_state_;
+};
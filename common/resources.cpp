@@ -0,0 +1,103 @@
+#include "resources.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define FIT_MASK_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// rows [from, end), bit of row i is (i - begin)
+template<FitDirection Direction>
+void FitMaskScalar(const uint32_t* const* columns, size_t dims, size_t begin, size_t from, size_t end, const uint32_t* bound, uint64_t* mask) {
+	for (size_t i = from; i < end; ++i) {
+		bool fits = true;
+
+		for (size_t dim = 0; dim < dims && fits; ++dim) {
+			fits = Direction == FitDirection::kAtLeast ? columns[dim][i] >= bound[dim] : columns[dim][i] <= bound[dim];
+		}
+
+		mask[(i - begin) / 64] |= uint64_t{fits} << ((i - begin) % 64);
+	}
+}
+
+#ifdef FIT_MASK_X86
+
+template<FitDirection Direction>
+__attribute__((target("avx2")))
+void FitMaskAvx2(const uint32_t* const* columns, size_t dims, size_t begin, size_t end, const uint32_t* bound, uint64_t* mask) {
+	size_t i = begin;
+
+	for (; i + 8 <= end; i += 8) {
+		__m256i fits = _mm256_set1_epi32(-1);
+
+		for (size_t dim = 0; dim < dims; ++dim) {
+			__m256i row = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(columns[dim] + i));
+			__m256i limit = _mm256_set1_epi32(bound[dim]);
+			// unsigned a >= b is max(a, b) == a
+			__m256i extreme = Direction == FitDirection::kAtLeast ? _mm256_max_epu32(row, limit) : _mm256_min_epu32(row, limit);
+			fits = _mm256_and_si256(fits, _mm256_cmpeq_epi32(extreme, row));
+		}
+
+		uint64_t bits = static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(fits)));
+		mask[(i - begin) / 64] |= bits << ((i - begin) % 64);
+	}
+
+	FitMaskScalar<Direction>(columns, dims, begin, i, end, bound, mask);
+}
+
+template<FitDirection Direction>
+__attribute__((target("avx512f")))
+void FitMaskAvx512(const uint32_t* const* columns, size_t dims, size_t begin, size_t end, const uint32_t* bound, uint64_t* mask) {
+	size_t i = begin;
+
+	for (; i + 16 <= end; i += 16) {
+		__mmask16 fits = 0xFFFF;
+
+		for (size_t dim = 0; dim < dims; ++dim) {
+			__m512i row = _mm512_loadu_si512(columns[dim] + i);
+			__m512i limit = _mm512_set1_epi32(bound[dim]);
+			fits &= Direction == FitDirection::kAtLeast ? _mm512_cmpge_epu32_mask(row, limit) : _mm512_cmple_epu32_mask(row, limit);
+		}
+
+		mask[(i - begin) / 64] |= uint64_t{fits} << ((i - begin) % 64);
+	}
+
+	FitMaskScalar<Direction>(columns, dims, begin, i, end, bound, mask);
+}
+
+#endif
+
+template<FitDirection Direction>
+void FitMaskDispatch(const uint32_t* const* columns, size_t dims, size_t begin, size_t end, const uint32_t* bound, uint64_t* mask) {
+#ifdef FIT_MASK_X86
+	static const bool has_avx512 = __builtin_cpu_supports("avx512f");
+	static const bool has_avx2 = __builtin_cpu_supports("avx2");
+
+	if (has_avx512) {
+		return FitMaskAvx512<Direction>(columns, dims, begin, end, bound, mask);
+	}
+	if (has_avx2) {
+		return FitMaskAvx2<Direction>(columns, dims, begin, end, bound, mask);
+	}
+#endif
+	FitMaskScalar<Direction>(columns, dims, begin, begin, end, bound, mask);
+}
+
+}
+
+void FitMask(
+	const uint32_t* const* columns,
+	size_t dims,
+	size_t begin,
+	size_t end,
+	const uint32_t* bound,
+	FitDirection direction,
+	uint64_t* mask
+) {
+	if (direction == FitDirection::kAtLeast) {
+		FitMaskDispatch<FitDirection::kAtLeast>(columns, dims, begin, end, bound, mask);
+	} else {
+		FitMaskDispatch<FitDirection::kAtMost>(columns, dims, begin, end, bound, mask);
+	}
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// dimensions of server capacities and VM demands
+enum ResourceKind : size_t {
+	kCpu,
+	kMem,
+	kDisk,
+	kNet,
+	kResourceKinds
+};
+
+constexpr std::array<std::string_view, kResourceKinds> kResourceNames = {"cpu", "memory", "disk", "network"};
+
+template<size_t Dims>
+struct ResourceVector {
+	std::array<size_t, Dims> values{};
+
+	size_t& operator[](size_t dim) { return values[dim]; }
+	size_t operator[](size_t dim) const { return values[dim]; }
+
+	bool FitsInto(const ResourceVector& capacity) const {
+		for (size_t dim = 0; dim < Dims; ++dim) {
+			if (values[dim] > capacity.values[dim]) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	ResourceVector& operator+=(const ResourceVector& other) {
+		for (size_t dim = 0; dim < Dims; ++dim) {
+			values[dim] += other.values[dim];
+		}
+		return *this;
+	}
+
+	ResourceVector& operator-=(const ResourceVector& other) {
+		for (size_t dim = 0; dim < Dims; ++dim) {
+			values[dim] -= other.values[dim];
+		}
+		return *this;
+	}
+};
+
+using Resources = ResourceVector<kResourceKinds>;
+
+enum class FitDirection {
+	kAtLeast, // row >= bound in every dimension: servers able to host a demand
+	kAtMost // row <= bound in every dimension: demands fitting into a capacity
+};
+
+/*
+	Rows are compared to a bound on all dimensions in `dims` columns of uint32, and bit (i - begin)
+	of `mask` is set for matching rows i of [begin, end). `mask` must hold (end - begin + 63) / 64
+	zeroed words. Uses AVX-512 or AVX2 when the CPU has them, scalar code otherwise.
+*/
+void FitMask(
+	const uint32_t* const* columns,
+	size_t dims,
+	size_t begin,
+	size_t end,
+	const uint32_t* bound,
+	FitDirection direction,
+	uint64_t* mask
+);
+
+template<size_t Dims>
+class ResourceTable {
+	/*
+		Resource vectors of many rows (servers or VMs) stored column by column, so one bound can be
+		checked against all rows with vector instructions. Values are saturated to 32 bits.
+	*/
+public:
+	void Resize(size_t rows) {
+		for (auto& column : columns_) {
+			column.resize(rows);
+		}
+	}
+
+	size_t Rows() const { return columns_[0].size(); }
+
+	void Set(size_t row, const ResourceVector<Dims>& value) {
+		for (size_t dim = 0; dim < Dims; ++dim) {
+			columns_[dim][row] = Saturate(value[dim]);
+		}
+	}
+
+	// bit (i - begin) of `mask` is set if row i of [begin, end) compares to `bound` as `direction` says
+	void Match(
+		const ResourceVector<Dims>& bound,
+		FitDirection direction,
+		size_t begin,
+		size_t end,
+		std::vector<uint64_t>* mask
+	) const {
+		std::array<const uint32_t*, Dims> columns;
+		std::array<uint32_t, Dims> bound32;
+
+		for (size_t dim = 0; dim < Dims; ++dim) {
+			columns[dim] = columns_[dim].data();
+			bound32[dim] = Saturate(bound[dim]);
+		}
+
+		mask->assign((end - begin + 63) / 64, 0);
+		FitMask(columns.data(), Dims, begin, end, bound32.data(), direction, mask->data());
+	}
+
+private:
+	static uint32_t Saturate(size_t value) {
+		return value > UINT32_MAX ? UINT32_MAX : value;
+	}
+
+private:
+	std::array<std::vector<uint32_t>, Dims> columns_;
+};
@@ -1,30 +1,173 @@
 #include "solution.h"
 
-Server::Server(const ServerSpec& spec, size_t id)
-	: free_mem_(spec.mem)
-	, free_cpu_(spec.cpu)
+#include <algorithm>
+#include <cmath>
+
+Resources Demand(const VM& vm) {
+	Resources result;
+	result[kCpu] = vm.cpu;
+	result[kMem] = vm.mem;
+	result[kDisk] = vm.disk;
+	result[kNet] = vm.net;
+	return result;
+}
+
+Resources Capacity(const ServerSpec& spec) {
+	Resources result;
+	result[kCpu] = spec.cpu;
+	result[kMem] = spec.mem;
+	result[kDisk] = spec.disk;
+	result[kNet] = spec.net;
+	return result;
+}
+
+TimeMoment MigrationDuration(const Problem& problem, size_t vm_id, size_t from, size_t to) {
+	TimeMoment base = problem.vms[vm_id].migration_time;
+	if (problem.topology.Empty()) {
+		return base;
+	}
+
+	long double multiplier = problem.topology.hop_multiplier[problem.topology.Hop(from, to)];
+#ifdef TICK_TIME
+	return base > 0 ? std::max<TimeMoment>(1, std::llround(base * multiplier)) : 0;
+#else
+	return static_cast<TimeMoment>(base * multiplier);
+#endif
+}
+
+ProblemVMs::ProblemVMs(const std::vector<VM>& vms) {
+	table_.Assign(vms);
+}
+
+std::vector<VM> ProblemVMs::ToVector() const {
+	return std::vector<VM>(begin(), end());
+}
+
+size_t ProblemVMs::MemoryBytes() const {
+	return table_.MemoryBytes();
+}
+
+size_t Solution::VMCount() const {
+	return vm_offsets_.empty() ? 0 : vm_offsets_.size() - 1;
+}
+
+size_t Solution::MovementsCount() const {
+	return movements_.size();
+}
+
+std::span<const Movement> Solution::GetVMMovements(size_t vm_id) const {
+	return std::span<const Movement>(movements_).subspan(
+		vm_offsets_[vm_id], vm_offsets_[vm_id + 1] - vm_offsets_[vm_id]
+	);
+}
+
+std::span<const Movement> Solution::GetMovements() const {
+	return movements_;
+}
+
+SolutionBuilder::SolutionBuilder(size_t vms)
+	: vm_moves_count_(vms, 0)
+{
+}
+
+void SolutionBuilder::Reset(size_t vms) {
+	vm_moves_count_.assign(vms, 0);
+	movements_.clear();
+}
+
+void SolutionBuilder::AddMovement(size_t vm_id, size_t from, size_t to, TimeMoment start_moment, TimeMoment duration) {
+	AddMovement(Movement{
+		.from = static_cast<uint32_t>(from),
+		.to = static_cast<uint32_t>(to),
+		.vm_id = static_cast<uint32_t>(vm_id),
+		.start_moment = start_moment,
+		.duration = duration
+	});
+}
+
+void SolutionBuilder::AddMovement(const Movement& move) {
+	if (move.vm_id >= vm_moves_count_.size()) {
+		throw std::out_of_range("Movement of unknown VM#" + std::to_string(move.vm_id));
+	}
+
+	++vm_moves_count_[move.vm_id];
+	movements_.push_back(move);
+}
+
+Solution SolutionBuilder::Build() {
+	// stable counting sort by VM, so each VM keeps its movements in order of adding
+
+	Solution result;
+	result.vm_offsets_.resize(vm_moves_count_.size() + 1, 0);
+
+	for (size_t i = 0; i < vm_moves_count_.size(); ++i) {
+		result.vm_offsets_[i + 1] = result.vm_offsets_[i] + vm_moves_count_[i];
+	}
+
+	std::vector<uint32_t> insert_pos(result.vm_offsets_.begin(), result.vm_offsets_.end() - 1);
+	result.movements_.resize(movements_.size());
+
+	for (const auto& move : movements_) {
+		result.movements_[insert_pos[move.vm_id]++] = move;
+	}
+
+	std::fill(vm_moves_count_.begin(), vm_moves_count_.end(), 0);
+	movements_.clear();
+
+	return result;
+}
+
+Server::Server(const ServerSpec& spec, size_t id, std::pmr::memory_resource* resource)
+	: free_(Capacity(spec))
 	, free_download_connections_(spec.max_in)
 	, free_upload_connections_(spec.max_out)
 	, id_(id)
+	, vms_(resource)
 	, spec_(spec)
 {
 }
 
-void Server::ReceiveVM(const VM& vm) {
-	if (free_mem_ < vm.mem) {
-		throw std::runtime_error("Server #" + std::to_string(id_) + " has not enough memory for the move");
+void Server::Reset(const ServerSpec& spec, size_t id) {
+	free_ = Capacity(spec);
+	free_download_connections_ = spec.max_in;
+	free_upload_connections_ = spec.max_out;
+	id_ = id;
+	vms_.clear();
+	spec_ = spec;
+}
+
+void ResetServers(
+	std::vector<Server>* servers,
+	const std::vector<ServerSpec>& specs,
+	std::pmr::memory_resource* resource
+) {
+	if (servers->size() > specs.size()) {
+		servers->erase(servers->begin() + specs.size(), servers->end());
 	}
 
-	if (free_cpu_ < vm.cpu) {
-		throw std::runtime_error("Server #" + std::to_string(id_) + " has not enough cpu for the move");
+	for (size_t i = 0; i < servers->size(); ++i) {
+		(*servers)[i].Reset(specs[i], i);
+	}
+
+	for (size_t i = servers->size(); i < specs.size(); ++i) {
+		servers->emplace_back(specs[i], i, resource);
+	}
+}
+
+void Server::ReceiveVM(const VM& vm) {
+	Resources demand = Demand(vm);
+	for (size_t dim = 0; dim < kResourceKinds; ++dim) {
+		if (free_[dim] < demand[dim]) {
+			throw std::runtime_error("Server #" + std::to_string(id_) + " has not enough " +
+				std::string(kResourceNames[dim]) + " for the move");
+		}
 	}
 
 	if (!free_download_connections_) {
 		throw std::runtime_error("Server #" + std::to_string(id_) + " cannot receive so many VMs at one moment");
 	}
 
-	free_cpu_ -= vm.cpu;
-	free_mem_ -= vm.mem;
+	free_ -= demand;
 	--free_download_connections_;
 }
 
@@ -46,8 +189,7 @@ void Server::CancelReceivingVM(const VM& vm) {
 }
 
 void Server::CancelSendingVM(const VM& vm) {
-	free_mem_ += vm.mem;
-	free_cpu_ += vm.cpu;
+	free_ += Demand(vm);
 	vms_.erase(vm.id);
 	++free_upload_connections_;
 }
@@ -56,16 +198,20 @@ bool Server::HasVM(size_t vm_id) const {
 	return (vms_.contains(vm_id));
 }
 
-std::set<size_t>* Server::GetRawVMSet() {
+std::pmr::set<size_t>* Server::GetRawVMSet() {
 	return &vms_;
 }
 
 std::tuple<size_t, size_t> Server::GetFreeSpace() const {
-	return {free_cpu_, free_mem_};
+	return {free_[kCpu], free_[kMem]};
+}
+
+const Resources& Server::GetFreeResources() const {
+	return free_;
 }
 
 bool Server::CanFit(const VM& vm) const {
-	return vm.mem <= free_mem_ && vm.cpu <= free_cpu_;
+	return Demand(vm).FitsInto(free_);
 }
 
 bool Server::CanSendVM() const {
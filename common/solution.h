@@ -1,17 +1,34 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory_resource>
 #include <set>
+#include <span>
 #include <stdexcept>
 #include <tuple>
 #include <vector>
 
+#include "resources.h"
+#include "time_base.h"
+#include "topology.h"
+#include "vm_table.h"
+
 struct VM {
 	size_t cpu;
 	size_t mem;
 	size_t id;
-	long double migration_time;
+	TimeMoment migration_time;
+	size_t disk = 0;
+	size_t net = 0; // reserved bandwidth
+	double priority = 1; // weight of the VM's completion time
+	TimeMoment deadline = kNoDeadline; // the VM should be on its final server by then
 };
 
+Resources Demand(const VM& vm);
+
 struct VMArrangement {
 	std::vector<size_t> vm_server; // i-th element is index of i-th VM's server 
 };
@@ -21,33 +38,132 @@ struct ServerSpec {
 	size_t cpu;
 	size_t max_out;
 	size_t max_in;
+	size_t disk = 0;
+	size_t net = 0;
 };
 
+Resources Capacity(const ServerSpec& spec);
+
 struct Movement {
-	size_t from;
-	size_t to;
-	long double start_moment;
-	long double duration;
-	size_t vm_id;
+	uint32_t from;
+	uint32_t to;
+	uint32_t vm_id;
+	TimeMoment start_moment;
+	TimeMoment duration;
+};
+
+class ProblemVMs {
+	/*
+		VMs of a problem, read-only. They are kept only as a VMTable; a VM is put together from its
+		row on access, so reads look like those of a const std::vector<VM> but yield values.
+		Changing VMs means assigning a new vector.
+	*/
+public:
+	ProblemVMs() = default;
+	ProblemVMs(const std::vector<VM>& vms); // order of `vms` must be ids
+
+	VM operator[](size_t vm_id) const {
+		return VM{
+			.cpu = table_.Cpu(vm_id),
+			.mem = table_.Mem(vm_id),
+			.id = vm_id,
+			.migration_time = table_.MigrationTime(vm_id),
+			.disk = table_.Column(kDisk)[vm_id],
+			.net = table_.Column(kNet)[vm_id],
+			.priority = table_.Priority(vm_id),
+			.deadline = table_.Deadline(vm_id)
+		};
+	}
+	size_t size() const { return table_.Size(); }
+	bool empty() const { return !table_.Size(); }
+
+	class Iterator {
+	public:
+		using iterator_category = std::input_iterator_tag;
+		using value_type = VM;
+		using difference_type = std::ptrdiff_t;
+
+		Iterator() = default;
+		Iterator(const ProblemVMs* vms, size_t vm_id) : vms_(vms), vm_id_(vm_id) {}
+
+		VM operator*() const { return (*vms_)[vm_id_]; }
+		Iterator& operator++() {
+			++vm_id_;
+			return *this;
+		}
+		Iterator operator++(int) {
+			Iterator prev = *this;
+			++*this;
+			return prev;
+		}
+		bool operator==(const Iterator& other) const { return vm_id_ == other.vm_id_; }
+
+	private:
+		const ProblemVMs* vms_ = nullptr;
+		size_t vm_id_ = 0;
+	};
+
+	Iterator begin() const { return Iterator(this, 0); }
+	Iterator end() const { return Iterator(this, size()); }
+
+	std::vector<VM> ToVector() const; // copy to change and assign back
+	const VMTable& Table() const { return table_; }
+
+	size_t MemoryBytes() const; // allocated by the table
+
+private:
+	VMTable table_;
 };
 
 struct Problem {
 	VMArrangement start_position;
 	VMArrangement end_position;
-	std::vector<VM> vms;
+	ProblemVMs vms;
 	std::vector<ServerSpec> server_specs;
+	Topology topology; // empty for a flat network
 };
 
-struct Solution {
-	std::vector<std::vector<Movement>> vm_movements; // i-th vector - movements of i-th VM
+// duration of moving the VM between two servers: its migration time scaled by the hop class
+TimeMoment MigrationDuration(const Problem& problem, size_t vm_id, size_t from, size_t to);
 
-	Solution(size_t vms) : vm_movements(vms) {}
+class Solution {
+public:
 	Solution() = default;
+
+	size_t VMCount() const;
+	size_t MovementsCount() const;
+
+	std::span<const Movement> GetVMMovements(size_t vm_id) const; // in order they were added
+	std::span<const Movement> GetMovements() const; // all movements, grouped by VM
+
+private:
+	friend class SolutionBuilder;
+
+	std::vector<uint32_t> vm_offsets_; // movements of i-th VM are [vm_offsets_[i], vm_offsets_[i + 1])
+	std::vector<Movement> movements_;
+};
+
+class SolutionBuilder {
+public:
+	explicit SolutionBuilder(size_t vms = 0);
+
+	void Reset(size_t vms); // drops added movements, keeps capacity
+
+	void AddMovement(size_t vm_id, size_t from, size_t to, TimeMoment start_moment, TimeMoment duration);
+	void AddMovement(const Movement& move);
+
+	Solution Build(); // builder is empty afterwards
+
+private:
+	std::vector<uint32_t> vm_moves_count_;
+	std::vector<Movement> movements_; // in order of adding
 };
 
 class Server {
 public:
-	Server(const ServerSpec& spec, size_t id);
+	Server(const ServerSpec& spec, size_t id, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+	void Reset(const ServerSpec& spec, size_t id); // empty server, keeps allocated memory where possible
 
 	void ReceiveVM(const VM& vm);
 	void SendVM(const VM& vm);
@@ -61,20 +177,27 @@ public:
 	bool HasVM(size_t vm_id) const;
 
 	std::tuple<size_t, size_t> GetFreeSpace() const; // {cpu, mem}
+	const Resources& GetFreeResources() const;
 	bool CanFit(const VM& vm) const;
 
-	std::set<size_t>* GetRawVMSet();
+	std::pmr::set<size_t>* GetRawVMSet();
 
 private:
-	size_t free_mem_;
-	size_t free_cpu_;
+	Resources free_;
 	size_t free_download_connections_;
 	size_t free_upload_connections_;
 	size_t id_;
-	std::set<size_t> vms_;
+	std::pmr::set<size_t> vms_;
 	ServerSpec spec_;
 };
 
+// resizes `servers` to one empty server per spec, reusing existing objects; new ones take VM sets from `resource`
+void ResetServers(
+	std::vector<Server>* servers,
+	const std::vector<ServerSpec>& specs,
+	std::pmr::memory_resource* resource = std::pmr::get_default_resource()
+);
+
 struct AlgoStats {
 	size_t cycle_breaks_;
 	// TODO: time measurement here;
@@ -0,0 +1,277 @@
+#include "solution_io.h"
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <type_traits>
+
+constexpr std::string_view kScheduleMagic = "VMSCHED";
+constexpr uint64_t kScheduleFormatVersion = 1;
+constexpr bool kTickTime = std::is_integral_v<TimeMoment>;
+constexpr size_t kReadChunk = 1 << 20; // a record grows by this much as its bytes arrive
+
+void PutVarint(std::string* out, uint64_t value) {
+	while (value >= 0x80) {
+		out->push_back(static_cast<char>(value | 0x80));
+		value >>= 7;
+	}
+	out->push_back(static_cast<char>(value));
+}
+
+uint64_t ZigZag(int64_t value) {
+	return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+int64_t UnZigZag(uint64_t value) {
+	return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+void PutDouble(std::string* out, double value) {
+	char bytes[sizeof(double)];
+	std::memcpy(bytes, &value, sizeof(double));
+	out->append(bytes, sizeof(double));
+}
+
+// raw time of this build: zigzag varint of ticks or 8 bytes of double
+void PutTime(std::string* out, TimeMoment value) {
+	if constexpr (kTickTime) {
+		PutVarint(out, ZigZag(value));
+	} else {
+		PutDouble(out, value);
+	}
+}
+
+uint64_t GetVarint(std::string_view* data) {
+	uint64_t value = 0;
+
+	for (size_t shift = 0; shift < 64; shift += 7) {
+		if (data->empty()) {
+			throw std::runtime_error("Truncated schedule record");
+		}
+
+		uint8_t byte = data->front();
+		data->remove_prefix(1);
+		value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+
+		if (!(byte & 0x80)) {
+			return value;
+		}
+	}
+
+	throw std::runtime_error("Malformed varint in schedule record");
+}
+
+// false on a clean end of the stream before the first byte
+bool GetVarint(std::istream& in, uint64_t* value) {
+	*value = 0;
+
+	for (size_t shift = 0; shift < 64; shift += 7) {
+		int byte = in.get();
+
+		if (byte == std::char_traits<char>::eof()) {
+			if (shift == 0) {
+				return false;
+			}
+			throw std::runtime_error("Truncated schedule stream");
+		}
+
+		*value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+
+		if (!(byte & 0x80)) {
+			return true;
+		}
+	}
+
+	throw std::runtime_error("Malformed varint in schedule stream");
+}
+
+double GetDouble(std::string_view* data) {
+	if (data->size() < sizeof(double)) {
+		throw std::runtime_error("Truncated schedule record");
+	}
+
+	double value;
+	std::memcpy(&value, data->data(), sizeof(double));
+	data->remove_prefix(sizeof(double));
+	return value;
+}
+
+TimeMoment GetTime(std::string_view* data) {
+	if constexpr (kTickTime) {
+		return UnZigZag(GetVarint(data));
+	} else {
+		return GetDouble(data);
+	}
+}
+
+ScheduleWriter::ScheduleWriter(std::ostream& out)
+	: out_(out)
+{
+	buffer_.assign(kScheduleMagic);
+	PutVarint(&buffer_, kScheduleFormatVersion);
+	PutVarint(&buffer_, kTickTime);
+	PutVarint(&buffer_, static_cast<uint64_t>(kTicksPerUnit));
+	out_.write(buffer_.data(), buffer_.size());
+}
+
+void ScheduleWriter::Write(uint64_t test_id, const Solution& solution) {
+	std::string& record = buffer_;
+	record.clear();
+
+	PutVarint(&record, test_id);
+	PutVarint(&record, solution.VMCount());
+
+	for (size_t vm = 0; vm < solution.VMCount(); ++vm) {
+		std::span<const Movement> moves = solution.GetVMMovements(vm);
+
+		bool uniform = !moves.empty() && std::all_of(moves.begin(), moves.end(), [&](const Movement& move) {
+			return move.duration == moves.front().duration;
+		});
+
+		PutVarint(&record, moves.size() << 1 | uniform);
+		if (uniform) {
+			PutTime(&record, moves.front().duration);
+		}
+
+		TimeMoment prev_end = 0;
+
+		for (size_t i = 0; i < moves.size(); ++i) {
+			const Movement& move = moves[i];
+			bool from_differs = i == 0 || move.from != moves[i - 1].to;
+
+			PutVarint(&record, static_cast<uint64_t>(move.to) << 1 | from_differs);
+			if (from_differs) {
+				PutVarint(&record, move.from);
+			}
+
+			if constexpr (kTickTime) {
+				PutVarint(&record, ZigZag(move.start_moment - prev_end));
+			} else {
+				PutDouble(&record, move.start_moment);
+			}
+
+			if (!uniform) {
+				PutTime(&record, move.duration);
+			}
+
+			prev_end = move.start_moment + move.duration;
+		}
+	}
+
+	std::string length;
+	PutVarint(&length, record.size());
+	out_.write(length.data(), length.size());
+	out_.write(record.data(), record.size());
+}
+
+ScheduleReader::ScheduleReader(std::istream& in)
+	: in_(in)
+{
+	std::string magic(kScheduleMagic.size(), '\0');
+	in_.read(magic.data(), magic.size());
+
+	uint64_t version = 0, ticks = 0, ticks_per_unit = 0;
+	if (magic != kScheduleMagic || !GetVarint(in_, &version) || !GetVarint(in_, &ticks) ||
+		!GetVarint(in_, &ticks_per_unit)) {
+		throw std::runtime_error("Not a schedule stream");
+	}
+
+	if (version != kScheduleFormatVersion) {
+		throw std::runtime_error("Unsupported schedule format version " + std::to_string(version));
+	}
+
+	// converted times could overlap by rounding where the original ones only touched
+	if (static_cast<bool>(ticks) != kTickTime || ticks_per_unit != static_cast<uint64_t>(kTicksPerUnit)) {
+		throw std::runtime_error("Schedule stream was written by a build with another time base");
+	}
+}
+
+bool ScheduleReader::Read(uint64_t* test_id, Solution* solution) {
+	uint64_t length = 0;
+	if (!GetVarint(in_, &length)) {
+		return false;
+	}
+
+	// a corrupt length fails on the missing bytes instead of allocating all of it upfront
+	buffer_.clear();
+	while (buffer_.size() < length) {
+		size_t offset = buffer_.size();
+		size_t chunk = std::min<uint64_t>(kReadChunk, length - offset);
+		buffer_.resize(offset + chunk);
+
+		if (!in_.read(buffer_.data() + offset, chunk)) {
+			throw std::runtime_error("Truncated schedule stream");
+		}
+	}
+
+	std::string_view data = buffer_;
+
+	*test_id = GetVarint(&data);
+	uint64_t vm_count = GetVarint(&data);
+	if (vm_count > data.size()) { // every VM takes at least one byte
+		throw std::runtime_error("VM count " + std::to_string(vm_count) + " exceeds the schedule record");
+	}
+	builder_.Reset(vm_count);
+
+	for (size_t vm = 0; vm < vm_count; ++vm) {
+		uint64_t header = GetVarint(&data);
+		size_t moves_count = header >> 1;
+		bool uniform = header & 1;
+
+		TimeMoment duration = uniform ? GetTime(&data) : 0;
+		TimeMoment prev_end = 0;
+		uint64_t prev_to = 0;
+
+		for (size_t i = 0; i < moves_count; ++i) {
+			uint64_t to = GetVarint(&data);
+			uint64_t from = to & 1 ? GetVarint(&data) : prev_to;
+			to >>= 1;
+
+			TimeMoment start;
+			if constexpr (kTickTime) {
+				start = prev_end + UnZigZag(GetVarint(&data));
+			} else {
+				start = GetDouble(&data);
+			}
+
+			if (!uniform) {
+				duration = GetTime(&data);
+			}
+
+			if (from > UINT32_MAX || to > UINT32_MAX) {
+				throw std::runtime_error("Server id out of range in schedule record");
+			}
+
+			builder_.AddMovement(vm, from, to, start, duration);
+			prev_end = start + duration;
+			prev_to = to;
+		}
+	}
+
+	if (!data.empty()) {
+		throw std::runtime_error("Trailing bytes in schedule record");
+	}
+
+	*solution = builder_.Build();
+	return true;
+}
+
+std::string EncodeSchedule(const Solution& solution) {
+	std::ostringstream out;
+	ScheduleWriter writer(out);
+	writer.Write(0, solution);
+	return std::move(out).str();
+}
+
+Solution DecodeSchedule(std::string_view data) {
+	std::istringstream in{std::string(data)};
+	ScheduleReader reader(in);
+
+	uint64_t test_id;
+	Solution solution;
+	if (!reader.Read(&test_id, &solution)) {
+		throw std::runtime_error("Empty schedule");
+	}
+	return solution;
+}
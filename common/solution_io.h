@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+#include "solution.h"
+
+/*
+	Compact binary schedule stream.
+		header:  magic "VMSCHED", format version, time base (0: double, 1: ticks), ticks per unit
+		record:  byte length, test id, VM count, then movements grouped by VM
+		per VM:  (moves count << 1 | uniform duration), the duration once if all moves share it
+		per move: (to << 1 | from differs from previous `to`), from if it differs,
+			start and, unless uniform, duration
+	Integers are LEB128 varints. With integer ticks the start is a zigzag delta from the end of
+	the previous move of the same VM (0 for back-to-back hops); double times are stored as raw
+	8 bytes, since a delta of doubles would not round-trip exactly. A stream is only readable by
+	builds with the same time base.
+*/
+
+class ScheduleWriter {
+public:
+	explicit ScheduleWriter(std::ostream& out); // writes the header
+
+	void Write(uint64_t test_id, const Solution& solution);
+
+private:
+	std::ostream& out_;
+	std::string buffer_; // encoded record, reused
+};
+
+class ScheduleReader {
+public:
+	explicit ScheduleReader(std::istream& in); // reads the header, throws on foreign streams
+
+	bool Read(uint64_t* test_id, Solution* solution); // false at the end of the stream
+
+private:
+	std::istream& in_;
+	SolutionBuilder builder_;
+	std::string buffer_;
+};
+
+// stream of a single schedule, e.g. for a cache entry
+std::string EncodeSchedule(const Solution& solution);
+Solution DecodeSchedule(std::string_view data);
@@ -0,0 +1,154 @@
+#include "statistics.h"
+
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace Statistics {
+
+constexpr size_t kMaxIterations = 300;
+constexpr long double kEps = 1e-15;
+constexpr long double kTiny = 1e-300;
+
+long double BetaContinuedFraction(long double a, long double b, long double x) {
+	// modified Lentz's method
+	long double qab = a + b;
+	long double qap = a + 1;
+	long double qam = a - 1;
+	long double c = 1;
+	long double d = 1 - qab * x / qap;
+
+	if (std::fabs(d) < kTiny) {
+		d = kTiny;
+	}
+	d = 1 / d;
+	long double h = d;
+
+	for (size_t m = 1; m <= kMaxIterations; ++m) {
+		long double m2 = 2 * m;
+		long double aa = m * (b - m) * x / ((qam + m2) * (a + m2));
+
+		d = 1 + aa * d;
+		if (std::fabs(d) < kTiny) {
+			d = kTiny;
+		}
+		c = 1 + aa / c;
+		if (std::fabs(c) < kTiny) {
+			c = kTiny;
+		}
+		d = 1 / d;
+		h *= d * c;
+
+		aa = -(a + m) * (qab + m) * x / ((a + m2) * (qap + m2));
+
+		d = 1 + aa * d;
+		if (std::fabs(d) < kTiny) {
+			d = kTiny;
+		}
+		c = 1 + aa / c;
+		if (std::fabs(c) < kTiny) {
+			c = kTiny;
+		}
+		d = 1 / d;
+
+		long double delta = d * c;
+		h *= delta;
+
+		if (std::fabs(delta - 1) < kEps) {
+			break;
+		}
+	}
+
+	return h;
+}
+
+long double RegularizedIncompleteBeta(long double a, long double b, long double x) {
+	if (x <= 0) {
+		return 0;
+	}
+
+	if (x >= 1) {
+		return 1;
+	}
+
+	long double front = std::exp(
+		std::lgamma(a + b) - std::lgamma(a) - std::lgamma(b) + a * std::log(x) + b * std::log(1 - x)
+	);
+
+	if (x < (a + 1) / (a + b + 2)) {
+		return front * BetaContinuedFraction(a, b, x) / a;
+	}
+
+	return 1 - front * BetaContinuedFraction(b, a, 1 - x) / b;
+}
+
+long double StudentTCdf(long double t, long double df) {
+	long double tail = RegularizedIncompleteBeta(df / 2, 0.5, df / (df + t * t)) / 2; // P(T > |t|)
+	return t > 0 ? 1 - tail : tail;
+}
+
+long double StudentTQuantile(long double p, long double df) {
+	if (p <= 0 || p >= 1) {
+		throw std::invalid_argument("Student t quantile is defined for p in (0, 1)");
+	}
+
+	long double low = -1e6;
+	long double high = 1e6;
+
+	for (size_t i = 0; i < kMaxIterations && high - low > kEps * std::max<long double>(1, std::fabs(low)); ++i) {
+		long double mid = (low + high) / 2;
+
+		if (StudentTCdf(mid, df) < p) {
+			low = mid;
+		} else {
+			high = mid;
+		}
+	}
+
+	return (low + high) / 2;
+}
+
+ConfidenceInterval MeanConfidenceInterval(const MetricsAccumulator& accum, long double level) {
+	long double mean = accum.GetMean();
+
+	if (accum.TotalCount() < 2) {
+		return {mean, mean};
+	}
+
+	long double df = accum.TotalCount() - 1;
+	long double half_width = StudentTQuantile((1 + level) / 2, df) * accum.GetStdDev() / std::sqrt(accum.TotalCount());
+
+	return {mean - half_width, mean + half_width};
+}
+
+TTestResult PairedTTest(const std::vector<long double>& lhs, const std::vector<long double>& rhs) {
+	if (lhs.size() != rhs.size()) {
+		throw std::invalid_argument("Paired t-test needs samples of equal size");
+	}
+
+	MetricsAccumulator diffs("diff");
+	for (size_t i = 0; i < lhs.size(); ++i) {
+		diffs.AppendMetric(rhs[i] - lhs[i]);
+	}
+
+	TTestResult result{diffs.GetMean(), 0, 1};
+
+	if (diffs.TotalCount() < 2) {
+		return result;
+	}
+
+	long double stderr_mean = diffs.GetStdDev() / std::sqrt(diffs.TotalCount());
+
+	if (stderr_mean == 0) {
+		result.t = result.mean_diff == 0 ? 0 : std::copysign(std::numeric_limits<long double>::infinity(), result.mean_diff);
+		result.p_value = result.mean_diff == 0 ? 1 : 0;
+		return result;
+	}
+
+	result.t = result.mean_diff / stderr_mean;
+	result.p_value = 2 * StudentTCdf(-std::fabs(result.t), diffs.TotalCount() - 1);
+
+	return result;
+}
+
+}
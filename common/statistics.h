@@ -0,0 +1,30 @@
+#pragma once
+
+#include <vector>
+
+#include "metrics.h"
+
+namespace Statistics {
+
+	long double RegularizedIncompleteBeta(long double a, long double b, long double x);
+
+	long double StudentTCdf(long double t, long double df);
+	long double StudentTQuantile(long double p, long double df);
+
+	struct ConfidenceInterval {
+		long double low;
+		long double high;
+	};
+
+	// two-sided interval for the mean, Student t based
+	ConfidenceInterval MeanConfidenceInterval(const MetricsAccumulator& accum, long double level = 0.95);
+
+	struct TTestResult {
+		long double mean_diff; // mean of (rhs - lhs)
+		long double t;
+		long double p_value; // two-sided
+	};
+
+	TTestResult PairedTTest(const std::vector<long double>& lhs, const std::vector<long double>& rhs);
+
+}
@@ -0,0 +1,17 @@
+#include "time_base.h"
+
+#include <algorithm>
+#include <cmath>
+
+TimeMoment DurationFromUnits(long double units) {
+#ifdef TICK_TIME
+	// positive durations never collapse to zero, otherwise moves could overlap
+	return units > 0 ? std::max<TimeMoment>(1, std::llround(units * kTicksPerUnit)) : 0;
+#else
+	return static_cast<TimeMoment>(units);
+#endif
+}
+
+long double TimeToUnits(TimeMoment moment) {
+	return moment / kTicksPerUnit;
+}
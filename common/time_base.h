@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+
+// moments and durations of migrations
+#ifdef TICK_TIME
+using TimeMoment = int64_t; // durations are quantized to integer ticks on load
+constexpr long double kTicksPerUnit = 1000;
+#else
+using TimeMoment = double;
+constexpr long double kTicksPerUnit = 1;
+#endif
+
+TimeMoment DurationFromUnits(long double units); // input boundary: dataset, generators
+long double TimeToUnits(TimeMoment moment); // output boundary: metrics, dumps
+
+constexpr TimeMoment kNoDeadline = std::numeric_limits<TimeMoment>::max();
@@ -0,0 +1,69 @@
+#include "topology.h"
+
+#include <algorithm>
+#include <cstdint>
+
+bool Topology::Empty() const {
+	return server_rack.empty();
+}
+
+size_t Topology::Rack(size_t server) const {
+	return server_rack[server];
+}
+
+size_t Topology::Pod(size_t server) const {
+	return rack_pod[server_rack[server]];
+}
+
+HopClass Topology::Hop(size_t from, size_t to) const {
+	if (Empty() || Rack(from) == Rack(to)) {
+		return kIntraRack;
+	}
+	return Pod(from) == Pod(to) ? kIntraPod : kCrossPod;
+}
+
+size_t Topology::UplinkLimit(size_t pod) const {
+	return pod < pod_uplink_limit.size() ? pod_uplink_limit[pod] : 0;
+}
+
+size_t Topology::PodsCount() const {
+	return rack_pod.empty() ? 0 : *std::max_element(rack_pod.begin(), rack_pod.end()) + 1;
+}
+
+void UplinkLoad::Reset(const Topology& topology) {
+	topology_ = &topology;
+	active_.assign(topology.PodsCount(), 0);
+}
+
+bool UplinkLoad::CanStart(size_t from, size_t to) const {
+	if (topology_->Hop(from, to) != kCrossPod) {
+		return true;
+	}
+	return !Saturated(topology_->Pod(from)) && !Saturated(topology_->Pod(to));
+}
+
+void UplinkLoad::Start(size_t from, size_t to) {
+	if (topology_->Hop(from, to) == kCrossPod) {
+		++active_[topology_->Pod(from)];
+		++active_[topology_->Pod(to)];
+	}
+}
+
+void UplinkLoad::Finish(size_t from, size_t to) {
+	if (topology_->Hop(from, to) == kCrossPod) {
+		--active_[topology_->Pod(from)];
+		--active_[topology_->Pod(to)];
+	}
+}
+
+size_t UplinkLoad::Free(size_t pod) const {
+	size_t limit = topology_->UplinkLimit(pod);
+	if (limit == 0) {
+		return SIZE_MAX;
+	}
+	return active_[pod] < limit ? limit - active_[pod] : 0;
+}
+
+bool UplinkLoad::Saturated(size_t pod) const {
+	return Free(pod) == 0;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// paths a migration can take through the network, from the cheapest one
+enum HopClass : size_t {
+	kIntraRack,
+	kIntraPod,
+	kCrossPod,
+	kHopClasses
+};
+
+constexpr std::array<std::string_view, kHopClasses> kHopClassNames = {"intra_rack", "intra_pod", "cross_pod"};
+
+struct Topology {
+	/*
+		Optional network of a fleet: servers stand in racks, racks in pods. Without racks the
+		network is flat and a move takes exactly the VM's migration time, otherwise this time is
+		scaled by the multiplier of the move's hop class. A cross-pod move also occupies the
+		uplinks of both pods, each carrying at most `pod_uplink_limit[pod]` transfers at once
+		(0 or a missing entry means unlimited).
+	*/
+	std::vector<uint32_t> server_rack;
+	std::vector<uint32_t> rack_pod;
+	std::array<double, kHopClasses> hop_multiplier = {1, 1, 1};
+	std::vector<uint32_t> pod_uplink_limit;
+
+	bool Empty() const;
+
+	size_t Rack(size_t server) const;
+	size_t Pod(size_t server) const;
+	HopClass Hop(size_t from, size_t to) const;
+
+	size_t UplinkLimit(size_t pod) const; // 0 if unlimited
+	size_t PodsCount() const;
+};
+
+class UplinkLoad {
+	/*
+		Cross-pod transfers in flight through every pod uplink. Moves inside a pod and moves on
+		a flat network never wait for an uplink.
+	*/
+public:
+	void Reset(const Topology& topology);
+
+	bool CanStart(size_t from, size_t to) const;
+	void Start(size_t from, size_t to);
+	void Finish(size_t from, size_t to);
+
+	size_t Free(size_t pod) const; // transfers this uplink can take more, SIZE_MAX if unlimited
+	bool Saturated(size_t pod) const;
+
+private:
+	const Topology* topology_ = nullptr;
+	std::vector<uint32_t> active_; // per pod
+};
@@ -0,0 +1,53 @@
+#include "vm_table.h"
+
+#include <stdexcept>
+#include <string>
+
+#include "solution.h"
+
+void VMTable::Assign(const std::vector<VM>& vms) {
+	for (auto& column : demand_) {
+		column.resize(vms.size());
+	}
+	migration_time_.resize(vms.size());
+	priority_.resize(vms.size());
+	deadline_.resize(vms.size());
+
+	for (size_t vm_id = 0; vm_id < vms.size(); ++vm_id) {
+		const VM& vm = vms[vm_id];
+		Resources demand = ::Demand(vm);
+
+		if (vm.id != vm_id) {
+			throw std::invalid_argument("VM #" + std::to_string(vm.id) + " is stored at row " + std::to_string(vm_id));
+		}
+
+		for (size_t kind = 0; kind < kResourceKinds; ++kind) {
+			if (demand[kind] > UINT32_MAX) {
+				throw std::out_of_range("VM #" + std::to_string(vm_id) + " demands more " +
+					std::string(kResourceNames[kind]) + " than fits 32 bits");
+			}
+			demand_[kind][vm_id] = demand[kind];
+		}
+
+		migration_time_[vm_id] = vm.migration_time;
+		priority_[vm_id] = vm.priority;
+		deadline_[vm_id] = vm.deadline;
+	}
+}
+
+Resources VMTable::Demand(size_t vm_id) const {
+	Resources result;
+	for (size_t kind = 0; kind < kResourceKinds; ++kind) {
+		result[kind] = demand_[kind][vm_id];
+	}
+	return result;
+}
+
+size_t VMTable::MemoryBytes() const {
+	size_t result = migration_time_.capacity() * sizeof(TimeMoment);
+	result += priority_.capacity() * sizeof(double) + deadline_.capacity() * sizeof(TimeMoment);
+	for (const auto& column : demand_) {
+		result += column.capacity() * sizeof(uint32_t);
+	}
+	return result;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "resources.h"
+#include "time_base.h"
+
+struct VM;
+
+class VMTable {
+	/*
+		The VMs of a problem stored by columns: every field is a column of its own, the id is the
+		row. Resources are 32-bit (the dataset format is int32 anyway), so a VM takes 40 bytes
+		instead of a 64-byte VM struct, and a scan of one field reads only that field.
+	*/
+public:
+	// rows follow the order of `vms`, which must be ids; throws if a demand does not fit 32 bits
+	void Assign(const std::vector<VM>& vms);
+
+	size_t Size() const { return migration_time_.size(); }
+
+	uint32_t Cpu(size_t vm_id) const { return demand_[kCpu][vm_id]; }
+	uint32_t Mem(size_t vm_id) const { return demand_[kMem][vm_id]; }
+	Resources Demand(size_t vm_id) const;
+	TimeMoment MigrationTime(size_t vm_id) const { return migration_time_[vm_id]; }
+	double Priority(size_t vm_id) const { return priority_[vm_id]; }
+	TimeMoment Deadline(size_t vm_id) const { return deadline_[vm_id]; }
+
+	std::span<const uint32_t> Column(ResourceKind kind) const { return demand_[kind]; }
+	std::span<const TimeMoment> MigrationTimes() const { return migration_time_; }
+
+	size_t MemoryBytes() const; // allocated by the columns
+
+private:
+	std::array<std::vector<uint32_t>, kResourceKinds> demand_;
+	std::vector<TimeMoment> migration_time_;
+	std::vector<double> priority_;
+	std::vector<TimeMoment> deadline_;
+};
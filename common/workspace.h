@@ -0,0 +1,28 @@
+#pragma once
+
+#include <memory>
+#include <typeindex>
+#include <unordered_map>
+
+class SolverWorkspace {
+	/*
+		Long-lived scratch storage passed into solvers by the caller. Every solver keeps its own
+		scratch struct here; containers in it keep their capacity between calls and are reset at
+		the beginning of each solve, so solving instances back to back does not reallocate.
+		Not thread-safe: use one workspace per thread.
+	*/
+public:
+	template<class Scratch>
+	Scratch& Get() {
+		auto& slot = slots_[std::type_index(typeid(Scratch))];
+
+		if (!slot) {
+			slot = std::make_shared<Scratch>();
+		}
+
+		return *static_cast<Scratch*>(slot.get());
+	}
+
+private:
+	std::unordered_map<std::type_index, std::shared_ptr<void>> slots_;
+};
@@ -0,0 +1,268 @@
+#include <iostream>
+#include <limits>
+#include <map>
+#include <random>
+
+#include <glog/logging.h>
+
+#include "mutations.h"
+#include "../testenv_lib/test_environment.h"
+#include "../testenv_lib/test_generator.h"
+#include "../algorithms_lib/algorithms.h"
+#include "../algorithms_lib/registry.h"
+
+// PROTO
+#include "../proto/test_case.pb.h"
+#include "../proto/metrics.pb.h"
+
+/*
+	Searches for problems an algorithm handles badly: a (mu + lambda) evolution over mutated
+	generator outputs, scored either by solve time or by the plan's TotalTime relative to the
+	timespan lower bound. Unsolved problems and rejected plans score highest.
+	The best problems are shrunk while they keep most of their score and saved as a dataset,
+	so they can be run by ./benchmark like any other one.
+*/
+
+constexpr size_t kMutationsPerChild = 3;
+constexpr size_t kMutationAttempts = 20; // before an infeasible child is given up
+constexpr double kShrinkKeep = 0.9; // share of the score a shrunk problem has to keep
+constexpr size_t kShrinkEvaluations = 200;
+
+enum class Fitness {
+	kSolveTime,
+	kLowerBoundGap
+};
+
+struct Candidate {
+	Problem problem;
+	double score = 0;
+	bool failed = false; // unsolved or the plan was rejected
+};
+
+class Evaluator {
+public:
+	Evaluator(const AlgoRegistry::AlgorithmInfo& algo, Fitness fitness)
+		: algo_(algo)
+		, fitness_(fitness)
+		, env_(nullptr)
+	{
+		// solve times of tiny problems are noisy, a warm workspace and a few runs smooth them
+		env_.SetRepetitions(1, fitness == Fitness::kSolveTime ? 3 : 1);
+	}
+
+	void Evaluate(Candidate* candidate) {
+		Metrics::MetricsSet measurements;
+		candidate->failed = true;
+		candidate->score = std::numeric_limits<double>::infinity();
+		++evaluations_;
+
+		try {
+			if (!env_.RunTest(candidate->problem, 0, algo_.solve, &measurements)) {
+				return;
+			}
+		} catch (const std::exception& e) {
+			LOG(WARNING) << "Failure on a problem with " << candidate->problem.vms.size() << " VMs: " << e.what();
+			return;
+		}
+		env_.ClearMeasurements();
+
+		std::map<std::string, double> values;
+		for (const auto& metric : measurements.metrics(0).measurements()) {
+			values[metric.name()] = metric.value();
+		}
+
+		candidate->failed = false;
+		if (fitness_ == Fitness::kSolveTime) {
+			candidate->score = values["SolveTimeMs"];
+		} else {
+			long double bound = AlgoLowerBound::CountTimespanLowerBound(candidate->problem);
+			candidate->score = bound > 0 ? values[std::string(TotalTime::kName)] / bound : 1;
+		}
+	}
+
+	size_t Evaluations() const {
+		return evaluations_;
+	}
+
+private:
+	const AlgoRegistry::AlgorithmInfo& algo_;
+	Fitness fitness_;
+	TestEnvironment env_;
+	size_t evaluations_ = 0;
+};
+
+bool IsInteresting(const Candidate& candidate, const Candidate& original) {
+	if (original.failed) {
+		return candidate.failed;
+	}
+	return candidate.failed || candidate.score >= original.score * kShrinkKeep;
+}
+
+/*
+	Delta debugging over VMs: chunks of VMs are dropped while the rest stays interesting, the
+	chunks get halved down to single VMs. Servers left empty in both arrangements go last.
+*/
+Candidate Shrink(const Candidate& original, Evaluator* evaluator) {
+	Candidate current = original;
+	size_t budget = evaluator->Evaluations() + kShrinkEvaluations;
+	size_t chunk = std::max<size_t>(1, current.problem.vms.size() / 2);
+
+	while (evaluator->Evaluations() < budget) {
+		bool progress = false;
+
+		for (size_t begin = 0; begin < current.problem.vms.size() && evaluator->Evaluations() < budget;) {
+			std::vector<bool> keep(current.problem.vms.size(), true);
+			std::fill(keep.begin() + begin, keep.begin() + std::min(begin + chunk, keep.size()), false);
+
+			Candidate smaller{Fuzz::KeepVMs(current.problem, keep)};
+			if (Fuzz::MisplacedVMs(smaller.problem) == 0) {
+				begin += chunk;
+				continue;
+			}
+
+			evaluator->Evaluate(&smaller);
+			if (IsInteresting(smaller, original)) {
+				current = std::move(smaller);
+				progress = true; // the next chunk moved into `begin`
+			} else {
+				begin += chunk;
+			}
+		}
+
+		if (!progress) {
+			if (chunk == 1) {
+				break;
+			}
+			chunk /= 2;
+		}
+	}
+
+	Candidate compact{Fuzz::DropEmptyServers(current.problem)};
+	evaluator->Evaluate(&compact);
+	return IsInteresting(compact, original) ? compact : current;
+}
+
+std::optional<Candidate> MakeChild(const Candidate& parent, std::mt19937& rnd) {
+	for (size_t attempt = 0; attempt < kMutationAttempts; ++attempt) {
+		Candidate child{parent.problem};
+		for (size_t i = 0; i < kMutationsPerChild; ++i) {
+			Fuzz::Mutate(&child.problem, rnd);
+		}
+
+		if (Fuzz::IsFeasible(child.problem)) {
+			return child;
+		}
+	}
+	return std::nullopt;
+}
+
+void SortByScore(std::vector<Candidate>* population) {
+	std::stable_sort(population->begin(), population->end(), [](const Candidate& lhs, const Candidate& rhs) {
+		return lhs.score > rhs.score;
+	});
+}
+
+std::string Describe(const Candidate& candidate) {
+	return (candidate.failed ? std::string("FAILED") : "score=" + std::to_string(candidate.score)) +
+		" vms=" + std::to_string(candidate.problem.vms.size()) +
+		" moving=" + std::to_string(Fuzz::MisplacedVMs(candidate.problem)) +
+		" servers=" + std::to_string(candidate.problem.server_specs.size());
+}
+
+void PrintUsage() {
+	std::cout << "USAGE: ./fuzzer [--fitness time|gap] [--iterations N] [--population P] [--keep K]\n"
+		<< "                [--seed S] [--servers-max M] ALGO_NAME OUTPUT_TESTS_PATH\n"
+		<< "time scores solve time, gap scores TotalTime over the lower bound.\n"
+		<< "The K best problems are shrunk and written as a dataset.\n";
+}
+
+int main(int argc, const char* argv[]) {
+	FLAGS_logtostderr = true;
+	google::InitGoogleLogging(argv[0]);
+	google::InstallFailureSignalHandler();
+
+	std::map<std::string, std::string> flags = {
+		{"--fitness", "gap"},
+		{"--iterations", "50"},
+		{"--population", "8"},
+		{"--keep", "5"},
+		{"--seed", "42"},
+		{"--servers-max", "200"},
+	};
+	std::vector<std::string> positional;
+
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (flags.count(arg) && i + 1 < argc) {
+			flags[arg] = argv[++i];
+		} else {
+			positional.push_back(arg);
+		}
+	}
+
+	if (positional.size() != 2 || (flags["--fitness"] != "time" && flags["--fitness"] != "gap")) {
+		PrintUsage();
+		return 1;
+	}
+
+	const AlgoRegistry::AlgorithmInfo* algo = AlgoRegistry::FindAlgorithm(positional[0]);
+	if (!algo) {
+		LOG(ERROR) << "Unknown algorithm `" << positional[0] << "`";
+		return 1;
+	}
+
+	Fitness fitness = flags["--fitness"] == "time" ? Fitness::kSolveTime : Fitness::kLowerBoundGap;
+	size_t iterations = std::stoul(flags["--iterations"]);
+	size_t population_size = std::max<size_t>(1, std::stoul(flags["--population"]));
+	size_t keep = std::stoul(flags["--keep"]);
+	size_t seed = std::stoul(flags["--seed"]);
+	size_t servers_max = std::max<size_t>(10, std::stoul(flags["--servers-max"]));
+
+	std::mt19937 rnd(seed);
+	Evaluator evaluator(*algo, fitness);
+
+	// half of the seeds are plain, half carry many short cycles
+	RealLifeGenerator real_life(seed, 15, servers_max / 2, servers_max);
+	CyclesGenerator cycles(seed, 15, 8, servers_max / 2, servers_max);
+
+	std::vector<Candidate> population;
+	for (size_t i = 0; i < population_size; ++i) {
+		Candidate seed_candidate{i % 2 == 0 ? real_life.Generate() : cycles.Generate()};
+		evaluator.Evaluate(&seed_candidate);
+		population.push_back(std::move(seed_candidate));
+	}
+	SortByScore(&population);
+
+	for (size_t iteration = 0; iteration < iterations; ++iteration) {
+		size_t parents = population.size();
+
+		for (size_t i = 0; i < parents; ++i) {
+			std::optional<Candidate> child = MakeChild(population[i], rnd);
+			if (child) {
+				evaluator.Evaluate(&*child);
+				population.push_back(std::move(*child));
+			}
+		}
+
+		SortByScore(&population);
+		population.resize(std::min(population.size(), population_size));
+
+		LOG(INFO) << "Iteration " << iteration << ": best " << Describe(population.front());
+	}
+
+	DataSet::DataSet dataset;
+	for (size_t i = 0; i < std::min(keep, population.size()); ++i) {
+		Candidate shrunk = Shrink(population[i], &evaluator);
+		LOG(INFO) << "Reproducer " << i << ": " << Describe(population[i]) << " -> " << Describe(shrunk);
+
+		DataSet::TestCase test = ConvertProblemToTestCase(shrunk.problem);
+		test.set_id(i);
+		*dataset.add_tests() = std::move(test);
+	}
+
+	DumpTests(dataset, positional[1]);
+	LOG(INFO) << "Saved " << dataset.tests_size() << " reproducers to `" << positional[1] << "` after "
+		<< evaluator.Evaluations() << " evaluations";
+
+	return 0;
+}
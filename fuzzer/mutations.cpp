@@ -0,0 +1,189 @@
+#include "mutations.h"
+
+#include <algorithm>
+#include <map>
+
+namespace Fuzz {
+
+constexpr size_t kMinCycleLength = 3;
+constexpr size_t kMaxCycleLength = 12;
+constexpr size_t kMaxStretch = 4;
+
+size_t RandomIndex(size_t size, std::mt19937& rnd) {
+	return std::uniform_int_distribution<size_t>(0, size - 1)(rnd);
+}
+
+std::vector<Resources> Loads(const Problem& problem, const VMArrangement& arrangement) {
+	std::vector<Resources> loads(problem.server_specs.size());
+	for (const auto& vm : problem.vms) {
+		loads[arrangement.vm_server[vm.id]] += Demand(vm);
+	}
+	return loads;
+}
+
+bool IsFeasible(const Problem& problem) {
+	for (const VMArrangement* arrangement : {&problem.start_position, &problem.end_position}) {
+		std::vector<Resources> loads = Loads(problem, *arrangement);
+
+		for (size_t i = 0; i < loads.size(); ++i) {
+			if (!loads[i].FitsInto(Capacity(problem.server_specs[i]))) {
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+void SwapDestinations(Problem* problem, std::mt19937& rnd) {
+	if (problem->vms.size() < 2) {
+		return;
+	}
+
+	size_t lhs = RandomIndex(problem->vms.size(), rnd);
+	size_t rhs = RandomIndex(problem->vms.size(), rnd);
+	std::swap(problem->end_position.vm_server[lhs], problem->end_position.vm_server[rhs]);
+}
+
+void TightenCapacity(Problem* problem, std::mt19937& rnd) {
+	if (problem->server_specs.empty()) {
+		return;
+	}
+
+	size_t server = RandomIndex(problem->server_specs.size(), rnd);
+	Resources start = Loads(*problem, problem->start_position)[server];
+	Resources end = Loads(*problem, problem->end_position)[server];
+
+	ServerSpec& spec = problem->server_specs[server];
+	spec.cpu = std::max(start[kCpu], end[kCpu]);
+	spec.mem = std::max(start[kMem], end[kMem]);
+}
+
+void LengthenCycle(Problem* problem, std::mt19937& rnd) {
+	// VMs of one size on distinct servers, each heading to the start server of the next one
+	std::map<std::pair<size_t, size_t>, std::vector<size_t>> by_size;
+	for (const auto& vm : problem->vms) {
+		by_size[{vm.cpu, vm.mem}].push_back(vm.id);
+	}
+
+	std::vector<std::vector<size_t>*> groups;
+	for (auto& [size, vms] : by_size) {
+		if (vms.size() >= kMinCycleLength) {
+			groups.push_back(&vms);
+		}
+	}
+	if (groups.empty()) {
+		return;
+	}
+
+	std::vector<size_t>& group = *groups[RandomIndex(groups.size(), rnd)];
+	std::shuffle(group.begin(), group.end(), rnd);
+
+	size_t length = std::uniform_int_distribution<size_t>(kMinCycleLength, kMaxCycleLength)(rnd);
+	std::vector<size_t> ring;
+	std::vector<bool> used(problem->server_specs.size(), false);
+
+	for (size_t vm_id : group) {
+		size_t server = problem->start_position.vm_server[vm_id];
+		if (!used[server]) {
+			used[server] = true;
+			ring.push_back(vm_id);
+		}
+		if (ring.size() == length) {
+			break;
+		}
+	}
+
+	if (ring.size() < kMinCycleLength) {
+		return;
+	}
+
+	for (size_t i = 0; i < ring.size(); ++i) {
+		problem->end_position.vm_server[ring[i]] = problem->start_position.vm_server[ring[(i + 1) % ring.size()]];
+	}
+}
+
+void StretchMigration(Problem* problem, std::mt19937& rnd) {
+	if (problem->vms.empty()) {
+		return;
+	}
+
+	std::vector<VM> vms = problem->vms.ToVector();
+	VM& vm = vms[RandomIndex(vms.size(), rnd)];
+	vm.migration_time *= std::uniform_int_distribution<size_t>(2, kMaxStretch)(rnd);
+	problem->vms = std::move(vms);
+}
+
+void Mutate(Problem* problem, std::mt19937& rnd) {
+	switch (RandomIndex(4, rnd)) {
+		case 0: SwapDestinations(problem, rnd); break;
+		case 1: TightenCapacity(problem, rnd); break;
+		case 2: LengthenCycle(problem, rnd); break;
+		default: StretchMigration(problem, rnd); break;
+	}
+}
+
+Problem KeepVMs(const Problem& problem, const std::vector<bool>& keep) {
+	Problem result;
+	result.server_specs = problem.server_specs;
+	result.topology = problem.topology;
+	std::vector<VM> vms;
+
+	for (const auto& vm : problem.vms) {
+		if (!keep[vm.id]) {
+			continue;
+		}
+
+		VM copy = vm;
+		copy.id = vms.size();
+		vms.push_back(copy);
+		result.start_position.vm_server.push_back(problem.start_position.vm_server[vm.id]);
+		result.end_position.vm_server.push_back(problem.end_position.vm_server[vm.id]);
+	}
+
+	result.vms = std::move(vms);
+	return result;
+}
+
+Problem DropEmptyServers(const Problem& problem) {
+	std::vector<size_t> new_id(problem.server_specs.size(), 0);
+	std::vector<bool> used(problem.server_specs.size(), false);
+
+	for (const auto& vm : problem.vms) {
+		used[problem.start_position.vm_server[vm.id]] = true;
+		used[problem.end_position.vm_server[vm.id]] = true;
+	}
+
+	Problem result;
+	result.topology = problem.topology;
+	result.topology.server_rack.clear();
+
+	for (size_t i = 0; i < problem.server_specs.size(); ++i) {
+		if (used[i]) {
+			new_id[i] = result.server_specs.size();
+			result.server_specs.push_back(problem.server_specs[i]);
+
+			if (!problem.topology.Empty()) {
+				result.topology.server_rack.push_back(problem.topology.server_rack[i]);
+			}
+		}
+	}
+
+	result.vms = problem.vms;
+	for (const auto& vm : problem.vms) {
+		result.start_position.vm_server.push_back(new_id[problem.start_position.vm_server[vm.id]]);
+		result.end_position.vm_server.push_back(new_id[problem.end_position.vm_server[vm.id]]);
+	}
+
+	return result;
+}
+
+size_t MisplacedVMs(const Problem& problem) {
+	size_t result = 0;
+	for (const auto& vm : problem.vms) {
+		result += problem.start_position.vm_server[vm.id] != problem.end_position.vm_server[vm.id];
+	}
+	return result;
+}
+
+}
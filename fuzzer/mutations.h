@@ -0,0 +1,30 @@
+#pragma once
+
+#include <random>
+#include <vector>
+
+#include "../common/solution.h"
+
+/*
+	Mutations and shrinking steps over Problems for the performance fuzzer. A mutation changes
+	the problem in place and may leave it infeasible (an arrangement overflowing a server), so
+	callers check IsFeasible and drop such results.
+*/
+
+namespace Fuzz {
+	bool IsFeasible(const Problem& problem); // both arrangements fit into the servers
+
+	void SwapDestinations(Problem* problem, std::mt19937& rnd); // two VMs exchange final servers
+	void TightenCapacity(Problem* problem, std::mt19937& rnd); // a server shrinks to its peak load
+	void LengthenCycle(Problem* problem, std::mt19937& rnd); // same-sized VMs form a ring of servers
+	void StretchMigration(Problem* problem, std::mt19937& rnd); // a VM migrates a few times slower
+
+	void Mutate(Problem* problem, std::mt19937& rnd); // one random mutation of the above
+
+	// VMs with `keep[id]`, renumbered in order
+	Problem KeepVMs(const Problem& problem, const std::vector<bool>& keep);
+	// servers without VMs in both arrangements are removed
+	Problem DropEmptyServers(const Problem& problem);
+
+	size_t MisplacedVMs(const Problem& problem);
+}
@@ -12,22 +12,57 @@
 
 #include "../common/solution.h"
 
+constexpr size_t kSeed = 147;
+constexpr size_t kServersMin = 500;
+constexpr size_t kServersMax = 1000;
+
+constexpr std::string_view kFatTreePrefix = "fat_tree_";
+constexpr std::string_view kSLAPrefix = "sla_";
+
+// nullptr for unknown names
+std::unique_ptr<ITestGenerator> MakeGenerator(const std::string& name) {
+	if (name.starts_with(kSLAPrefix)) {
+		std::unique_ptr<ITestGenerator> base = MakeGenerator(name.substr(kSLAPrefix.size()));
+		return base ? std::make_unique<SLAGenerator>(std::move(base), kSeed) : nullptr;
+	} else if (name.starts_with(kFatTreePrefix)) {
+		std::unique_ptr<ITestGenerator> base = MakeGenerator(name.substr(kFatTreePrefix.size()));
+		return base ? std::make_unique<FatTreeGenerator>(std::move(base)) : nullptr;
+	} else if (name == "real") {
+		return std::make_unique<RealLifeGenerator>(kSeed, 25, kServersMin, kServersMax);
+	} else if (name == "cycles") {
+		return std::make_unique<CyclesGenerator>(kSeed, 25, 15, kServersMin, kServersMax);
+	} else if (name == "evacuation") {
+		return std::make_unique<EvacuationGenerator>(kSeed, 5, kServersMin, kServersMax);
+	} else if (name == "rolling_upgrade") {
+		return std::make_unique<RollingUpgradeGenerator>(kSeed, 20, 2, kServersMin, kServersMax);
+	} else if (name == "consolidation") {
+		return std::make_unique<ConsolidationGenerator>(kSeed, 20, kServersMin, kServersMax);
+	} else if (name == "rebalance") {
+		return std::make_unique<RebalanceGenerator>(kSeed, 10, kServersMin, kServersMax);
+	}
+	return nullptr;
+}
+
 int main(int argc, const char* argv[]) {
 	FLAGS_logtostderr = true;
     google::InitGoogleLogging(argv[0]);
     google::InstallFailureSignalHandler();
 
     if (argc < 3) {
-    	std::cout << "USAGE: ./test_dumper GENERATOR_TYPE OUTPUT_TESTS_PATH";
+    	std::cout << "USAGE: ./test_dumper GENERATOR_TYPE OUTPUT_TESTS_PATH\n"
+    		<< "GENERATOR_TYPE: real, cycles, evacuation, rolling_upgrade, consolidation, rebalance,\n"
+    		<< "  any of them prefixed with fat_tree_ to place the servers into racks and pods,\n"
+    		<< "  any of those prefixed with sla_ to give some VMs high priorities and deadlines";
     	return 1;
     }
 
+	std::unique_ptr<ITestGenerator> generator = MakeGenerator(argv[1]);
+	if (!generator) {
+		LOG(ERROR) << "Unknown generator `" << argv[1] << "`";
+		return 1;
+	}
 
-	TestEnvironment test_env(
-		std::string{argv[1]} == "cycles" ? 
-		std::unique_ptr<ITestGenerator>(std::make_unique<CyclesGenerator>(147, 25, 15, 500, 1000)) : 
-		std::unique_ptr<ITestGenerator>(std::make_unique<RealLifeGenerator>(147, 25, 500, 1000))
-	);
+	TestEnvironment test_env(std::move(generator));
 
 	AlgoStatMaker statmaker;
 
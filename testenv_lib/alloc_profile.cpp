@@ -0,0 +1,60 @@
+#include "alloc_profile.h"
+
+#include <sys/resource.h>
+
+namespace AllocProfile {
+
+bool installed = false;
+
+// constant-initialized, so safe to touch from operator new at any point of a thread's life
+thread_local uint64_t allocations = 0;
+thread_local uint64_t allocated_bytes = 0;
+thread_local int64_t live_bytes = 0; // may go negative when memory of other threads is freed here
+thread_local int64_t scope_base = 0;
+thread_local int64_t scope_peak = 0;
+
+bool Enabled() {
+	return installed;
+}
+
+void StartScope() {
+	allocations = 0;
+	allocated_bytes = 0;
+	scope_base = live_bytes;
+	scope_peak = live_bytes;
+}
+
+Counters StopScope() {
+	Counters result;
+	result.allocations = allocations;
+	result.allocated_bytes = allocated_bytes;
+	result.peak_live_bytes = scope_peak - scope_base;
+	return result;
+}
+
+uint64_t PeakRSSBytes() {
+	rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0) {
+		return 0;
+	}
+	return static_cast<uint64_t>(usage.ru_maxrss) * 1024; // kilobytes on Linux
+}
+
+void MarkInstalled() {
+	installed = true;
+}
+
+void OnAllocate(size_t bytes) {
+	++allocations;
+	allocated_bytes += bytes;
+	live_bytes += bytes;
+	if (live_bytes > scope_peak) {
+		scope_peak = live_bytes;
+	}
+}
+
+void OnFree(size_t bytes) {
+	live_bytes -= bytes;
+}
+
+}
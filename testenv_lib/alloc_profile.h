@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+	Allocation profiling of solver calls. Counting needs the global operator new/delete
+	replacements from benchmarks/alloc_hooks.cpp, which are linked into `benchmark` only with
+	the ALLOC_PROFILE build option; otherwise Enabled() is false and scopes count nothing.
+	Counters are thread-local: allocations of helper threads spawned by a solver are not seen.
+*/
+
+namespace AllocProfile {
+	struct Counters {
+		uint64_t allocations = 0;
+		uint64_t allocated_bytes = 0;
+		uint64_t peak_live_bytes = 0; // over the live bytes at the start of the scope
+	};
+
+	bool Enabled();
+
+	// scopes of one thread do not nest
+	void StartScope();
+	Counters StopScope();
+
+	uint64_t PeakRSSBytes(); // of the whole process so far, 0 if unknown
+
+	// called by the hooks
+	void MarkInstalled();
+	void OnAllocate(size_t bytes);
+	void OnFree(size_t bytes);
+}
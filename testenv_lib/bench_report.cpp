@@ -0,0 +1,249 @@
+#include "bench_report.h"
+
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+
+#include <google/protobuf/util/json_util.h>
+
+#include "../common/statistics.h"
+
+const std::set<std::string> kHigherIsBetter = {
+	"MeanChannelUtilization",
+	"MaxChannelUtilization",
+	"IPC",
+	"ValidatorIPC"
+};
+
+// neither direction is a regression: the shape of a schedule, and raw hardware counts, which
+// depend on the machine and are compared through the rates derived from them
+const std::set<std::string> kInformational = {
+	"PeakConcurrentMigrations",
+	"PeakMemoryInFlight",
+	"Cycles",
+	"Instructions",
+	"CacheMisses",
+	"BranchInstructions",
+	"BranchMisses",
+	"ValidatorCycles",
+	"ValidatorInstructions",
+	"ValidatorCacheMisses",
+	"ValidatorBranchInstructions",
+	"ValidatorBranchMisses"
+};
+
+Metrics::Summary MakeSummary(const MetricsAccumulator& accum) {
+	Metrics::Summary summary;
+	Statistics::ConfidenceInterval ci = Statistics::MeanConfidenceInterval(accum);
+
+	summary.set_name(accum.GetName());
+	summary.set_count(accum.TotalCount());
+	summary.set_mean(accum.GetMean());
+	summary.set_stddev(accum.GetStdDev());
+	summary.set_ci_low(ci.low);
+	summary.set_ci_high(ci.high);
+
+	return summary;
+}
+
+void SummarizeMetrics(Metrics::MetricsSet* measurements) {
+	std::vector<MetricsAccumulator> accumulators;
+	std::map<std::string, size_t> index;
+
+	for (const auto& test : measurements->metrics()) {
+		for (const auto& metric : test.measurements()) {
+			auto [it, inserted] = index.emplace(metric.name(), accumulators.size());
+			if (inserted) {
+				accumulators.emplace_back(metric.name());
+			}
+			accumulators[it->second].AppendMetric(metric.value());
+		}
+	}
+
+	measurements->clear_summaries();
+	for (const auto& accum : accumulators) {
+		*measurements->add_summaries() = MakeSummary(accum);
+	}
+}
+
+void ReadJson(const std::string& json_path, google::protobuf::Message* message) {
+	std::ifstream file(json_path);
+
+	if (!file.is_open()) {
+		throw std::invalid_argument("Cannot load metrics from `" + json_path + "`");
+	}
+
+	std::stringstream content;
+	content << file.rdbuf();
+
+	auto status = google::protobuf::util::JsonStringToMessage(content.str(), message);
+
+	if (!status.ok()) {
+		throw std::runtime_error("Cannot parse metrics `" + json_path + "`: " + status.ToString());
+	}
+}
+
+void WriteJson(const google::protobuf::Message& message, const std::string& json_path) {
+	std::string result;
+	google::protobuf::util::JsonPrintOptions options;
+	options.add_whitespace = true;
+	options.preserve_proto_field_names = true;
+
+	google::protobuf::util::MessageToJsonString(message, &result, options);
+
+	std::ofstream fout(json_path, std::ios::binary | std::ios::trunc | std::ios::out);
+
+	if (!fout.is_open()) {
+		throw std::invalid_argument("Cannot dump metrics to `" + json_path + "`");
+	}
+
+	fout << result;
+}
+
+Metrics::MetricsSet LoadMetricsSet(const std::string& json_path) {
+	Metrics::MetricsSet measurements;
+	ReadJson(json_path, &measurements);
+	return measurements;
+}
+
+void DumpMetricsSet(const Metrics::MetricsSet& measurements, const std::string& json_path) {
+	WriteJson(measurements, json_path);
+}
+
+Metrics::BenchmarkResults LoadBenchmarkResults(const std::string& json_path) {
+	Metrics::BenchmarkResults results;
+	ReadJson(json_path, &results);
+	return results;
+}
+
+void DumpBenchmarkResults(const Metrics::BenchmarkResults& results, const std::string& json_path) {
+	WriteJson(results, json_path);
+}
+
+Metrics::MetricsSet SelectRun(const Metrics::BenchmarkResults& results, const std::string& algorithm) {
+	for (const auto& run : results.runs()) {
+		if (run.algorithm() == algorithm) {
+			return run;
+		}
+	}
+
+	throw std::invalid_argument("No results of `" + algorithm + "` in the benchmark results");
+}
+
+// test_id -> metric name -> value
+using MetricsByTest = std::map<int32_t, std::map<std::string, long double>>;
+
+MetricsByTest IndexByTest(const Metrics::MetricsSet& measurements) {
+	MetricsByTest result;
+
+	for (int i = 0; i < measurements.metrics_size(); ++i) {
+		const auto& test = measurements.metrics(i);
+		auto& values = result[test.has_test_id() ? test.test_id() : i];
+
+		for (const auto& metric : test.measurements()) {
+			values[metric.name()] = metric.value();
+		}
+	}
+
+	return result;
+}
+
+std::vector<MetricComparison> CompareMetricsSets(
+	const Metrics::MetricsSet& base,
+	const Metrics::MetricsSet& candidate,
+	long double threshold,
+	long double alpha
+) {
+	MetricsByTest base_tests = IndexByTest(base);
+	MetricsByTest candidate_tests = IndexByTest(candidate);
+
+	std::map<std::string, std::pair<std::vector<long double>, std::vector<long double>>> paired;
+	std::vector<std::string> order; // as metrics appear in the base set
+
+	for (const auto& test : base.metrics()) {
+		for (const auto& metric : test.measurements()) {
+			if (!paired.contains(metric.name())) {
+				paired[metric.name()];
+				order.push_back(metric.name());
+			}
+		}
+	}
+
+	for (const auto& [test_id, base_values] : base_tests) {
+		auto it = candidate_tests.find(test_id);
+		if (it == candidate_tests.end()) {
+			continue;
+		}
+
+		for (const auto& [name, value] : base_values) {
+			auto candidate_value = it->second.find(name);
+			if (candidate_value == it->second.end()) {
+				continue;
+			}
+
+			paired[name].first.push_back(value);
+			paired[name].second.push_back(candidate_value->second);
+		}
+	}
+
+	std::vector<MetricComparison> result;
+
+	for (const auto& name : order) {
+		const auto& [base_values, candidate_values] = paired[name];
+
+		MetricsAccumulator base_accum(name), candidate_accum(name);
+		for (size_t i = 0; i < base_values.size(); ++i) {
+			base_accum.AppendMetric(base_values[i]);
+			candidate_accum.AppendMetric(candidate_values[i]);
+		}
+
+		Statistics::TTestResult test = Statistics::PairedTTest(base_values, candidate_values);
+
+		MetricComparison comparison{
+			.name = name,
+			.paired_tests = base_values.size(),
+			.base_mean = base_accum.GetMean(),
+			.candidate_mean = candidate_accum.GetMean(),
+			.relative_change = 0,
+			.p_value = test.p_value,
+			.regression = false
+		};
+
+		if (comparison.base_mean != 0) {
+			comparison.relative_change = test.mean_diff / std::fabs(comparison.base_mean);
+		}
+
+		long double worsening = kHigherIsBetter.contains(name) ? -comparison.relative_change : comparison.relative_change;
+		comparison.regression = !kInformational.contains(name) && worsening > threshold && test.p_value < alpha;
+
+		result.push_back(comparison);
+	}
+
+	return result;
+}
+
+void PrintComparison(const std::vector<MetricComparison>& comparison, std::ostream& out) {
+	out << std::left << std::setw(28) << "metric"
+		<< std::right << std::setw(8) << "tests"
+		<< std::setw(16) << "base"
+		<< std::setw(16) << "candidate"
+		<< std::setw(10) << "change"
+		<< std::setw(12) << "p-value" << '\n';
+
+	for (const auto& metric : comparison) {
+		std::stringstream change;
+		change << std::showpos << std::fixed << std::setprecision(2) << 100 * metric.relative_change << '%';
+
+		out << std::left << std::setw(28) << metric.name
+			<< std::right << std::setw(8) << metric.paired_tests
+			<< std::setw(16) << metric.base_mean
+			<< std::setw(16) << metric.candidate_mean
+			<< std::setw(10) << change.str()
+			<< std::setw(12) << metric.p_value
+			<< (metric.regression ? "  REGRESSION" : "") << '\n';
+	}
+}
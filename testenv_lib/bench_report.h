@@ -0,0 +1,47 @@
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "../common/metrics.h"
+
+#include "../proto/metrics.pb.h"
+
+Metrics::Summary MakeSummary(const MetricsAccumulator& accum);
+
+// fills `summaries` of the set: one per metric name over all tests
+void SummarizeMetrics(Metrics::MetricsSet* measurements);
+
+Metrics::MetricsSet LoadMetricsSet(const std::string& json_path);
+void DumpMetricsSet(const Metrics::MetricsSet& measurements, const std::string& json_path);
+
+Metrics::BenchmarkResults LoadBenchmarkResults(const std::string& json_path);
+void DumpBenchmarkResults(const Metrics::BenchmarkResults& results, const std::string& json_path);
+
+// run of one algorithm from combined results, throws if it is absent
+Metrics::MetricsSet SelectRun(const Metrics::BenchmarkResults& results, const std::string& algorithm);
+
+struct MetricComparison {
+	std::string name;
+	size_t paired_tests;
+	long double base_mean;
+	long double candidate_mean;
+	long double relative_change; // (candidate - base) / base, positive means larger values
+	long double p_value; // paired t-test over tests solved in both sets
+	bool regression;
+};
+
+/*
+	Tests are matched by test_id. Metric is a regression if it became worse (larger, or smaller for
+	metrics where higher is better) by more than `threshold` relatively, and the paired t-test
+	rejects equality at `alpha` level.
+*/
+std::vector<MetricComparison> CompareMetricsSets(
+	const Metrics::MetricsSet& base,
+	const Metrics::MetricsSet& candidate,
+	long double threshold,
+	long double alpha = 0.05
+);
+
+void PrintComparison(const std::vector<MetricComparison>& comparison, std::ostream& out);
@@ -0,0 +1,112 @@
+#include "perf_counters.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+constexpr std::array<uint64_t, PerfCounters::kCountersCount> kEventConfigs = {
+	PERF_COUNT_HW_CPU_CYCLES,
+	PERF_COUNT_HW_INSTRUCTIONS,
+	PERF_COUNT_HW_CACHE_MISSES,
+	PERF_COUNT_HW_BRANCH_INSTRUCTIONS,
+	PERF_COUNT_HW_BRANCH_MISSES
+};
+
+int OpenCounter(uint64_t config, int group_fd) {
+	perf_event_attr attr;
+	std::memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = PERF_TYPE_HARDWARE;
+	attr.config = config;
+	attr.disabled = group_fd == -1; // members follow the leader
+	attr.exclude_kernel = 1; // allowed with perf_event_paranoid <= 2
+	attr.exclude_hv = 1;
+	attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_ID |
+		PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+	return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0));
+}
+
+PerfCounters::PerfCounters() {
+	fds_.fill(-1);
+
+	fds_[kCycles] = OpenCounter(kEventConfigs[kCycles], -1);
+	if (fds_[kCycles] == -1) {
+		unavailable_reason_ = std::string("perf_event_open: ") + std::strerror(errno);
+		return;
+	}
+
+	for (size_t i = kCycles + 1; i < kCountersCount; ++i) {
+		fds_[i] = OpenCounter(kEventConfigs[i], fds_[kCycles]);
+	}
+
+	for (size_t i = 0; i < kCountersCount; ++i) {
+		if (fds_[i] != -1) {
+			ioctl(fds_[i], PERF_EVENT_IOC_ID, &ids_[i]);
+		}
+	}
+}
+
+PerfCounters::~PerfCounters() {
+	for (int fd : fds_) {
+		if (fd != -1) {
+			close(fd);
+		}
+	}
+}
+
+bool PerfCounters::Available() const {
+	return fds_[kCycles] != -1;
+}
+
+const std::string& PerfCounters::UnavailableReason() const {
+	return unavailable_reason_;
+}
+
+void PerfCounters::Start() {
+	if (!Available()) {
+		return;
+	}
+
+	ioctl(fds_[kCycles], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+	ioctl(fds_[kCycles], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+std::optional<PerfCounters::Values> PerfCounters::Stop() {
+	if (!Available()) {
+		return std::nullopt;
+	}
+
+	ioctl(fds_[kCycles], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+	// nr, time_enabled, time_running, then {value, id} per counter; not on the heap, since
+	// Stop runs before the allocation profile of the solver call is closed
+	std::array<uint64_t, 3 + 2 * kCountersCount> buffer;
+	ssize_t bytes = read(fds_[kCycles], buffer.data(), buffer.size() * sizeof(uint64_t));
+	if (bytes < static_cast<ssize_t>(3 * sizeof(uint64_t))) {
+		return std::nullopt;
+	}
+
+	uint64_t nr = buffer[0], enabled = buffer[1], running = buffer[2];
+	if (running == 0) {
+		return std::nullopt; // the group never got onto the PMU
+	}
+	long double scale = static_cast<long double>(enabled) / running;
+
+	Values result;
+	for (size_t k = 0; k < nr && k < kCountersCount; ++k) {
+		uint64_t value = buffer[3 + 2 * k], id = buffer[4 + 2 * k];
+
+		for (size_t i = 0; i < kCountersCount; ++i) {
+			if (fds_[i] != -1 && ids_[i] == id) {
+				result.counters[i] = static_cast<uint64_t>(value * scale);
+			}
+		}
+	}
+
+	return result;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+/*
+	Hardware counters of the calling thread (user space only) via perf_event_open, read as one
+	group so all values cover the same interval. Values are scaled when the kernel multiplexes
+	the group. Counters which cannot be opened (no PMU in a VM, perf_event_paranoid, seccomp in
+	containers) are simply missing; without the leading cycles counter the whole group is
+	unavailable and Stop() returns nothing.
+*/
+
+class PerfCounters {
+public:
+	enum Counter {
+		kCycles,
+		kInstructions,
+		kCacheMisses,
+		kBranchInstructions,
+		kBranchMisses,
+		kCountersCount
+	};
+
+	static constexpr std::array<std::string_view, kCountersCount> kNames = {
+		"Cycles", "Instructions", "CacheMisses", "BranchInstructions", "BranchMisses"
+	};
+
+	struct Values {
+		std::array<std::optional<uint64_t>, kCountersCount> counters;
+	};
+
+	PerfCounters();
+	~PerfCounters();
+
+	PerfCounters(const PerfCounters&) = delete;
+	PerfCounters& operator=(const PerfCounters&) = delete;
+
+	bool Available() const;
+	const std::string& UnavailableReason() const;
+
+	void Start();
+	std::optional<Values> Stop();
+
+private:
+	std::array<int, kCountersCount> fds_;
+	std::array<uint64_t, kCountersCount> ids_ = {};
+	std::string unavailable_reason_;
+};
@@ -0,0 +1,138 @@
+#include "solution_cache.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+
+#include <unistd.h>
+
+#include <glog/logging.h>
+
+#include "../common/solution_io.h"
+
+#include "../proto/solution_cache.pb.h"
+
+#ifdef TICK_TIME
+constexpr std::string_view kTimeBase = "ticks";
+#else
+constexpr std::string_view kTimeBase = "double";
+#endif
+
+uint64_t MixBits(uint64_t x) { // splitmix64 finalizer
+	x ^= x >> 30;
+	x *= 0xbf58476d1ce4e5b9ULL;
+	x ^= x >> 27;
+	x *= 0x94d049bb133111ebULL;
+	x ^= x >> 31;
+	return x;
+}
+
+// two independent 64-bit lanes: FNV-1a and a multiply-rotate hash
+std::pair<uint64_t, uint64_t> Hash128(std::string_view data) {
+	uint64_t fnv = 0xcbf29ce484222325ULL;
+	uint64_t mul = 0x9e3779b97f4a7c15ULL ^ data.size();
+
+	for (unsigned char c : data) {
+		fnv = (fnv ^ c) * 0x100000001b3ULL;
+		mul = ((mul ^ c) * 0xff51afd7ed558ccdULL);
+		mul = (mul << 29) | (mul >> 35);
+	}
+
+	return {MixBits(fnv), MixBits(mul)};
+}
+
+SolutionCache::SolutionCache(std::string directory)
+	: directory_(std::move(directory))
+{
+	std::filesystem::create_directories(directory_);
+}
+
+std::string SolutionCache::Key(const DataSet::TestCase& test, std::string_view algorithm, uint32_t version) {
+	// test bytes, then zero-separated text fields (only the test bytes may contain zeros)
+	std::string content = test.SerializeAsString();
+	std::string version_tag = std::to_string(version);
+	for (std::string_view field : {algorithm, std::string_view(version_tag), kTimeBase}) {
+		content.push_back('\0');
+		content += field;
+	}
+
+	auto [high, low] = Hash128(content);
+
+	std::stringstream key;
+	key << std::hex << std::setfill('0') << std::setw(16) << high << std::setw(16) << low;
+	return key.str();
+}
+
+std::string SolutionCache::EntryPath(std::string_view algorithm, const std::string& key) const {
+	return (std::filesystem::path(directory_) / algorithm / (key + ".pb")).string();
+}
+
+std::optional<SolutionCache::Entry> SolutionCache::Lookup(std::string_view algorithm, const std::string& key) {
+	std::ifstream file(EntryPath(algorithm, key), std::ios::in | std::ios::binary);
+
+	Cache::Entry stored;
+	if (!file.is_open() || !stored.ParseFromIstream(&file) || (stored.solved() && !stored.has_schedule())) {
+		++misses_;
+		return std::nullopt;
+	}
+
+	Entry entry;
+	entry.metrics = stored.metrics();
+
+	if (stored.solved()) {
+		try {
+			entry.solution = DecodeSchedule(stored.schedule());
+		} catch (const std::runtime_error& e) {
+			// the test is solved again and its entry overwritten
+			LOG(WARNING) << "Damaged cache entry `" << EntryPath(algorithm, key) << "`: " << e.what();
+			++misses_;
+			return std::nullopt;
+		}
+	}
+
+	++hits_;
+	return entry;
+}
+
+void SolutionCache::Store(
+	std::string_view algorithm,
+	const std::string& key,
+	const std::optional<Solution>& solution,
+	const Metrics::Metrics& metrics
+) {
+	Cache::Entry stored;
+	stored.set_solved(solution.has_value());
+	*stored.mutable_metrics() = metrics;
+
+	if (solution) {
+		stored.set_schedule(EncodeSchedule(*solution));
+	}
+
+	std::string path = EntryPath(algorithm, key);
+	// unique per writer: processes sharing the directory never write into the same file
+	std::ostringstream tmp_name;
+	tmp_name << path << ".tmp." << getpid() << "." << std::hex << std::random_device{}();
+	std::string tmp_path = tmp_name.str();
+	std::filesystem::create_directories(std::filesystem::path(path).parent_path());
+
+	{
+		std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc | std::ios::out);
+		if (!file.is_open() || !stored.SerializeToOstream(&file)) {
+			throw std::runtime_error("Cannot write cache entry `" + tmp_path + "`");
+		}
+	}
+
+	// readers never see a partially written entry
+	std::filesystem::rename(tmp_path, path);
+}
+
+size_t SolutionCache::Hits() const {
+	return hits_;
+}
+
+size_t SolutionCache::Misses() const {
+	return misses_;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "../common/solution.h"
+
+#include "../proto/metrics.pb.h"
+#include "../proto/test_case.pb.h"
+
+/*
+	On-disk cache of solver results. Key is a hash of the serialized TestCase together with
+	the algorithm name, its version and the time base of the build, so a changed test, a bumped
+	algorithm version or another TimeMoment representation never hit stale entries.
+	Entries are files `<directory>/<algorithm>/<key>.pb`, written atomically via rename.
+*/
+
+class SolutionCache {
+public:
+	struct Entry {
+		std::optional<Solution> solution; // nullopt: algorithm failed on the test
+		Metrics::Metrics metrics; // per-test metrics of the original run, solve time included
+	};
+
+	explicit SolutionCache(std::string directory);
+
+	static std::string Key(const DataSet::TestCase& test, std::string_view algorithm, uint32_t version);
+
+	std::optional<Entry> Lookup(std::string_view algorithm, const std::string& key);
+	void Store(
+		std::string_view algorithm,
+		const std::string& key,
+		const std::optional<Solution>& solution,
+		const Metrics::Metrics& metrics
+	);
+
+	size_t Hits() const;
+	size_t Misses() const;
+
+private:
+	std::string EntryPath(std::string_view algorithm, const std::string& key) const;
+
+private:
+	std::string directory_;
+	size_t hits_ = 0;
+	size_t misses_ = 0;
+};
@@ -1,44 +1,54 @@
 #include "test_environment.h"
+#include "alloc_profile.h"
+#include "bench_report.h"
 
+#include <chrono>
 #include <stdexcept>
 #include <glog/logging.h>
 
 TestEnvironment::TestEnvironment(std::unique_ptr<ITestGenerator>&& test_generator)
-	: accumulators_{
-		MetricsAccumulator("TotalTime"),
-		MetricsAccumulator("TotalMemoryMigration"),
-		MetricsAccumulator("SumMigrationTime"),
-		MetricsAccumulator("TotalSteps")
-	}
+	: solve_time_("SolveTimeMs")
+	, test_solve_time_("SolveTimeMs")
+	, first_migration_time_("TimeToFirstMigrationMs")
 	, generator_(std::move(test_generator))
 {
-	metrics_.emplace_back(std::make_unique<TotalTime>());
-	metrics_.emplace_back(std::make_unique<TotalMemoryMigration>());
-	metrics_.emplace_back(std::make_unique<SumMigrationTime>());
-	metrics_.emplace_back(std::make_unique<TotalSteps>());
+	for (auto name : PlanMetrics::kNames) {
+		accumulators_.emplace_back(name);
+	}
 }
   
 void TestEnvironment::CheckCorrectness() const {
+	SolveArena arena; // all node containers of the check are dropped at once
 	std::vector<Server> servers;
-	servers.reserve(problem_.server_specs.size());
+	ResetServers(&servers, problem_->server_specs, arena.Resource());
+
+	// Check that the solution refers to this problem
+
+	if (solution_->VMCount() != problem_->vms.size()) {
+		throw std::runtime_error("Solution describes " + std::to_string(solution_->VMCount()) +
+			" VMs, problem has " + std::to_string(problem_->vms.size()));
+	}
 
-	for (size_t i = 0; i < problem_.server_specs.size(); ++i) {
-		servers.emplace_back(problem_.server_specs[i], i);
+	for (const auto& move : solution_->GetMovements()) {
+		if (move.from >= servers.size() || move.to >= servers.size()) {
+			throw std::runtime_error("Move of VM #" + std::to_string(move.vm_id) + " from server #" +
+				std::to_string(move.from) + " to #" + std::to_string(move.to) + " refers to a server out of " +
+				std::to_string(servers.size()));
+		}
 	}
 
 	// Fill start configuration
 
-	for (size_t i = 0; i < problem_.start_position.vm_server.size(); ++i) {
-		servers[problem_.start_position.vm_server[i]].ReceiveVM(problem_.vms[i]);
-		servers[problem_.start_position.vm_server[i]].CancelReceivingVM(problem_.vms[i]);
+	for (size_t i = 0; i < problem_->start_position.vm_server.size(); ++i) {
+		servers[problem_->start_position.vm_server[i]].ReceiveVM(problem_->vms[i]);
+		servers[problem_->start_position.vm_server[i]].CancelReceivingVM(problem_->vms[i]);
 	}
 
-	// Sort all moves
+	// Check moves of each VM
 
-	std::vector<Movement> movements;
-	for (const auto& vm_moves : solution_->vm_movements) {
-		long double prev_move_time = 0;
-		for (const auto& move : vm_moves) {
+	for (size_t i = 0; i < solution_->VMCount(); ++i) {
+		TimeMoment prev_move_time = 0;
+		for (const auto& move : solution_->GetVMMovements(i)) {
 			if (move.start_moment < prev_move_time) {
 				throw std::runtime_error("Moves are intersecting for VM #" + std::to_string(move.vm_id));
 			}
@@ -47,12 +57,19 @@ void TestEnvironment::CheckCorrectness() const {
 				throw std::runtime_error("Move starts at negative timestamp");
 			}
 
-			movements.emplace_back(move);
+			if (move.duration < MigrationDuration(*problem_, move.vm_id, move.from, move.to)) {
+				throw std::runtime_error("Move of VM #" + std::to_string(move.vm_id) + " from server #" +
+					std::to_string(move.from) + " to #" + std::to_string(move.to) + " is shorter than its path allows");
+			}
 
 			prev_move_time = move.start_moment + move.duration;
 		}
 	}
 
+	// Sort all moves
+
+	std::vector<Movement> movements(solution_->GetMovements().begin(), solution_->GetMovements().end());
+
 	std::sort(movements.begin(), movements.end(), [&]
 		(const Movement& lhs, const Movement& rhs) 
 	{	
@@ -61,39 +78,49 @@ void TestEnvironment::CheckCorrectness() const {
 
 	// Emulate
 
-	std::multimap<long double, Movement> transfer_endings;
+	std::pmr::multimap<TimeMoment, Movement> transfer_endings(arena.Resource());
+	UplinkLoad uplinks;
+	uplinks.Reset(problem_->topology);
 
 	for (auto& move : movements) {
 		// End passed transfers
-		long double current_moment = move.start_moment;
+		TimeMoment current_moment = move.start_moment;
 
 		while (!transfer_endings.empty() && transfer_endings.begin()->first <= current_moment) {
 			const auto& passed_move = transfer_endings.begin()->second;
 
-			servers[passed_move.from].CancelSendingVM(problem_.vms[passed_move.vm_id]);
-			servers[passed_move.to].CancelReceivingVM(problem_.vms[passed_move.vm_id]);
+			servers[passed_move.from].CancelSendingVM(problem_->vms[passed_move.vm_id]);
+			servers[passed_move.to].CancelReceivingVM(problem_->vms[passed_move.vm_id]);
+			uplinks.Finish(passed_move.from, passed_move.to);
 
 			transfer_endings.erase(transfer_endings.begin());
 		}
 
 		// Process current transfer
-		servers[move.from].SendVM(problem_.vms[move.vm_id]);
-		servers[move.to].ReceiveVM(problem_.vms[move.vm_id]);
+		if (!uplinks.CanStart(move.from, move.to)) {
+			throw std::runtime_error("Too many cross-pod transfers through an uplink when moving VM #" +
+				std::to_string(move.vm_id));
+		}
+		uplinks.Start(move.from, move.to);
+
+		servers[move.from].SendVM(problem_->vms[move.vm_id]);
+		servers[move.to].ReceiveVM(problem_->vms[move.vm_id]);
 		transfer_endings.insert({move.start_moment + move.duration, move});
 	}
 
 	while (!transfer_endings.empty()) {
 		const auto& passed_move = transfer_endings.begin()->second;
 
-		servers[passed_move.from].CancelSendingVM(problem_.vms[passed_move.vm_id]);
-		servers[passed_move.to].CancelReceivingVM(problem_.vms[passed_move.vm_id]);
+		servers[passed_move.from].CancelSendingVM(problem_->vms[passed_move.vm_id]);
+		servers[passed_move.to].CancelReceivingVM(problem_->vms[passed_move.vm_id]);
+		uplinks.Finish(passed_move.from, passed_move.to);
 
 		transfer_endings.erase(transfer_endings.begin());
 	}
 
 	// Check equality of the final configurations
-	for (size_t i = 0; i < problem_.end_position.vm_server.size(); ++i) {
-		size_t server_id = problem_.end_position.vm_server[i];
+	for (size_t i = 0; i < problem_->end_position.vm_server.size(); ++i) {
+		size_t server_id = problem_->end_position.vm_server[i];
 
 		if (!servers[server_id].HasVM(i)) {
 			throw std::runtime_error("Result configuration is not equal to ending one: "
@@ -108,20 +135,11 @@ Metrics::MetricsSet TestEnvironment::RunTests(size_t tests_count, AlgorithmCallb
 	Metrics::MetricsSet measurements;
 
 	for (size_t i = 0; i < tests_count; ++i) {
-		problem_ = generator_->Generate();
-		solution_ = solver(problem_, statmaker);
-
-		// PrintTest(problem_);
-
-		if (solution_) {
-			CheckCorrectness();
-			CountMetrics(&measurements);
-			++solved_cases;
-		}
+		owned_problem_ = generator_->Generate();
+		solved_cases += RunTest(owned_problem_, i, solver, &measurements, statmaker);
 	}
 
-	measurements.set_tests(tests_count);
-	measurements.set_solved(solved_cases);
+	FinishMeasurements(&measurements, tests_count, solved_cases);
 
 	return measurements;
 }
@@ -131,43 +149,270 @@ Metrics::MetricsSet TestEnvironment::RunTestsFromDataSet(DataSet::DataSet datase
 	Metrics::MetricsSet measurements;
 
 	for (size_t i = 0; i < dataset.tests_size(); ++i) {
-		problem_ = ConvertTestCaseToProblem(dataset.tests(i));
-		solution_ = solver(problem_, statmaker);
+		owned_problem_ = ConvertTestCaseToProblem(dataset.tests(i));
+		solved_cases += RunTest(owned_problem_, dataset.tests(i).id(), solver, &measurements, statmaker);
+	}
 
-		// PrintTest(problem_);
+	FinishMeasurements(&measurements, dataset.tests_size(), solved_cases);
 
-		if (solution_) {
-			CheckCorrectness();
-			CountMetrics(&measurements);
-			++solved_cases;
+	return measurements;
+}
+
+bool TestEnvironment::RunTest(
+	const Problem& problem,
+	size_t test_id,
+	const AlgorithmCallback& solver,
+	Metrics::MetricsSet* measurements,
+	AlgoStatMaker* statmaker
+) {
+	problem_ = &problem;
+	SolveCurrentProblem(solver, statmaker);
+
+	// PrintTest(*problem_);
+
+	if (solution_) {
+		ValidateSolution();
+		CountMetrics(measurements, test_id);
+	}
+
+	return solution_.has_value();
+}
+
+bool TestEnvironment::ReplayTest(
+	const Problem& problem,
+	size_t test_id,
+	const std::optional<Solution>& solution,
+	const Metrics::Metrics& cached,
+	bool validate,
+	Metrics::MetricsSet* measurements
+) {
+	problem_ = &problem;
+	solution_ = solution;
+
+	if (!solution_) {
+		return false;
+	}
+
+	if (validate) {
+		ValidateSolution(); // before any measurement of the test is recorded
+	}
+
+	Metrics::Metrics* test_measurements = measurements->add_metrics();
+	test_measurements->set_test_id(test_id);
+
+	if (validate) {
+		// plan metrics are recomputed too, their definitions may have changed since caching
+		AppendPlanMetrics(test_measurements);
+		AppendPerfMetrics(test_measurements, "Validator", validator_counters_);
+	}
+
+	for (const auto& metric : cached.measurements()) {
+		if (metric.name() == solve_time_.GetName()) {
+			solve_time_.AppendMetric(metric.value());
+		} else if (metric.name() == first_migration_time_.GetName()) {
+			first_migration_time_.AppendMetric(metric.value());
+		} else if (validate) {
+			continue;
+		} else {
+			auto accum = std::find_if(accumulators_.begin(), accumulators_.end(), [&](const MetricsAccumulator& accum) {
+				return accum.GetName() == metric.name();
+			});
+			if (accum != accumulators_.end()) {
+				accum->AppendMetric(metric.value());
+			}
 		}
+
+		*test_measurements->add_measurements() = metric;
 	}
 
-	measurements.set_tests(dataset.tests_size());
-	measurements.set_solved(solved_cases);
+	if (cached.has_solve_time()) {
+		*test_measurements->mutable_solve_time() = cached.solve_time();
+	}
 
-	return measurements;
+	return true;
+}
+
+const std::optional<Solution>& TestEnvironment::GetLastSolution() const {
+	return solution_;
 }
 
 bool TestEnvironment::GetStatOnTest(const Problem& problem, AlgorithmCallback solver, AlgoStatMaker* statmaker = nullptr) {
-	return static_cast<bool>(solver(problem, statmaker));
+	return static_cast<bool>(solver(problem, statmaker, &workspace_));
 }
 
-void TestEnvironment::CountMetrics(Metrics::MetricsSet* measurements) {
-	Metrics::Metrics* test_measurements = measurements->add_metrics();
+bool TestEnvironment::EnablePerfCounters() {
+	perf_ = std::make_unique<PerfCounters>();
+
+	if (!perf_->Available()) {
+		LOG(WARNING) << "Hardware counters are unavailable (" << perf_->UnavailableReason() << "), measuring time only";
+		perf_.reset();
+		return false;
+	}
+
+	return true;
+}
+
+void TestEnvironment::ValidateSolution() {
+	if (perf_) {
+		perf_->Start();
+	}
+	CheckCorrectness();
+	validator_counters_ = perf_ ? perf_->Stop() : std::nullopt;
+}
+
+void TestEnvironment::AppendPerfMetrics(
+	Metrics::Metrics* test_measurements,
+	const std::string& prefix,
+	const std::optional<PerfCounters::Values>& values
+) {
+	if (!values) {
+		return;
+	}
+
+	auto add = [&](std::string_view name, long double value) {
+		Metrics::Metric* metric = test_measurements->add_measurements();
+		metric->set_name(prefix + std::string(name));
+		metric->set_value(value);
+	};
+
+	const auto& counters = values->counters;
+	for (size_t i = 0; i < PerfCounters::kCountersCount; ++i) {
+		if (counters[i]) {
+			add(PerfCounters::kNames[i], *counters[i]);
+		}
+	}
+
+	// derived rates, only when both parts were counted
+	auto ratio = [&](std::string_view name, PerfCounters::Counter num, PerfCounters::Counter den, long double scale) {
+		if (counters[num] && counters[den] && *counters[den] > 0) {
+			add(name, scale * *counters[num] / *counters[den]);
+		}
+	};
+	ratio("IPC", PerfCounters::kInstructions, PerfCounters::kCycles, 1);
+	ratio("CacheMissesPerKiloInstr", PerfCounters::kCacheMisses, PerfCounters::kInstructions, 1000);
+	ratio("BranchMissRate", PerfCounters::kBranchMisses, PerfCounters::kBranchInstructions, 1);
+}
 
-	for (size_t i = 0; i < metrics_.size(); ++i) {
+void TestEnvironment::SetRepetitions(size_t warmup, size_t repetitions) {
+	if (!repetitions) {
+		throw std::invalid_argument("Each test should be solved at least once");
+	}
+
+	warmup_ = warmup;
+	repetitions_ = repetitions;
+}
+
+void TestEnvironment::SetStreamingSolver(StreamCallback stream) {
+	stream_ = std::move(stream);
+}
+
+void TestEnvironment::SolveCurrentProblem(const AlgorithmCallback& solver, AlgoStatMaker* statmaker) {
+	for (size_t i = 0; i < warmup_; ++i) {
+		solver(*problem_, nullptr, &workspace_);
+	}
+
+	test_solve_time_.Clear();
+
+	for (size_t i = 0; i < repetitions_; ++i) {
+		AllocProfile::StartScope();
+		if (perf_) {
+			perf_->Start();
+		}
+		auto start = std::chrono::steady_clock::now();
+		solution_ = solver(*problem_, i + 1 == repetitions_ ? statmaker : nullptr, &workspace_);
+		std::chrono::duration<long double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		solver_counters_ = perf_ ? perf_->Stop() : std::nullopt;
+		allocations_ = AllocProfile::StopScope();
+
+		solve_time_.AppendMetric(elapsed.count());
+		test_solve_time_.AppendMetric(elapsed.count());
+	}
+
+	test_first_migration_time_.reset();
+	if (stream_ && solution_) {
+		// until an executor could start migrating; the rest of the plan is dropped with the stream
+		auto start = std::chrono::steady_clock::now();
+		PlanStream plan = stream_(*problem_, nullptr, &workspace_);
+		plan.Next();
+		std::chrono::duration<long double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+		test_first_migration_time_ = elapsed.count();
+		first_migration_time_.AppendMetric(elapsed.count());
+	}
+}
+
+void TestEnvironment::AppendPlanMetrics(Metrics::Metrics* test_measurements) {
+	PlanMetrics::Values values = PlanMetrics::Evaluate(*problem_, *solution_);
+
+	for (size_t i = 0; i < values.size(); ++i) {
 		Metrics::Metric* single_measurement = test_measurements->add_measurements();
 		single_measurement->set_name(accumulators_[i].GetName());
-		long double res = metrics_[i]->Evaluate(problem_, *solution_);
-		single_measurement->set_value(res);
-		accumulators_[i].AppendMetric(res);
+		single_measurement->set_value(values[i]);
+		accumulators_[i].AppendMetric(values[i]);
+	}
+}
+
+void TestEnvironment::CountMetrics(Metrics::MetricsSet* measurements, size_t test_id) {
+	Metrics::Metrics* test_measurements = measurements->add_metrics();
+	test_measurements->set_test_id(test_id);
+
+	AppendPlanMetrics(test_measurements);
+
+	Metrics::Metric* solve_time = test_measurements->add_measurements();
+	solve_time->set_name(test_solve_time_.GetName());
+	solve_time->set_value(test_solve_time_.GetMean());
+	*test_measurements->mutable_solve_time() = MakeSummary(test_solve_time_);
+
+	if (test_first_migration_time_) {
+		Metrics::Metric* first_migration = test_measurements->add_measurements();
+		first_migration->set_name(first_migration_time_.GetName());
+		first_migration->set_value(*test_first_migration_time_);
 	}
+
+	AppendPerfMetrics(test_measurements, "", solver_counters_);
+	AppendPerfMetrics(test_measurements, "Validator", validator_counters_);
+
+	if (AllocProfile::Enabled()) { // of the last repetition
+		std::pair<const char*, uint64_t> counters[] = {
+			{"Allocations", allocations_.allocations},
+			{"AllocatedBytes", allocations_.allocated_bytes},
+			{"PeakLiveBytes", allocations_.peak_live_bytes},
+		};
+
+		for (auto [name, value] : counters) {
+			Metrics::Metric* metric = test_measurements->add_measurements();
+			metric->set_name(name);
+			metric->set_value(value);
+		}
+	}
+}
+
+void TestEnvironment::FinishMeasurements(Metrics::MetricsSet* measurements, size_t tests, size_t solved) const {
+	measurements->set_tests(tests);
+	measurements->set_solved(solved);
+	measurements->set_warmup(warmup_);
+	measurements->set_repetitions(repetitions_);
+	measurements->set_peak_rss_bytes(AllocProfile::PeakRSSBytes());
+	SummarizeMetrics(measurements);
 }
 
 void TestEnvironment::PrintMeasurements(std::ostream& out) const {
+	auto print = [&](const MetricsAccumulator& accum) {
+		out << accum.GetName() << ": "
+			<< "mean=" << accum.GetMean()
+			<< " stddev=" << accum.GetStdDev()
+			<< " p50=" << accum.GetQuantile(0.5)
+			<< " p90=" << accum.GetQuantile(0.9)
+			<< " p99=" << accum.GetQuantile(0.99)
+			<< " max=" << accum.GetMax() << '\n';
+	};
+
 	for (const auto& accum : accumulators_) {
-		out << accum.GetName() << ": " << "mean=" << accum.GetMean() << '\n';
+		print(accum);
+	}
+	print(solve_time_);
+	if (first_migration_time_.TotalCount()) {
+		print(first_migration_time_);
 	}
 }
 
@@ -175,6 +420,16 @@ void TestEnvironment::ClearMeasurements() {
 	for (auto& accum : accumulators_) {
 		accum.Clear();
 	}
+	solve_time_.Clear();
+	first_migration_time_.Clear();
+}
+
+void TestEnvironment::MergeMeasurements(const TestEnvironment& other) {
+	for (size_t i = 0; i < accumulators_.size(); ++i) {
+		accumulators_[i].Merge(other.accumulators_[i]);
+	}
+	solve_time_.Merge(other.solve_time_);
+	first_migration_time_.Merge(other.first_migration_time_);
 }	
 
 void TestEnvironment::GenerateAndDumpTests(const std::string& path, size_t test_count, TestPredicateCallback callback) {
@@ -199,38 +454,21 @@ void TestEnvironment::GenerateAndDumpTests(const std::string& path, size_t test_
 			continue;
 		}
 
-		DataSet::TestCase test;
-
+		DataSet::TestCase test = ConvertProblemToTestCase(problem);
 		test.set_id(generatedTests);
 
-		for (size_t i = 0; i < problem.vms.size(); ++i) {
-			DataSet::VM* vm = test.add_vms();
-
-			vm->set_cpu(problem.vms[i].cpu);
-			vm->set_mem(problem.vms[i].mem);
-			vm->set_id(problem.vms[i].id);
-			vm->set_migration_time(problem.vms[i].migration_time);
-		}
-
-		for (size_t i = 0; i < problem.server_specs.size(); ++i) {
-			DataSet::ServerSpec* spec = test.add_specs();
-
-			spec->set_mem(problem.server_specs[i].mem);
-			spec->set_cpu(problem.server_specs[i].cpu);
-			spec->set_max_in(problem.server_specs[i].max_in);
-			spec->set_max_out(problem.server_specs[i].max_out);
-		}
+		*(dataset.add_tests()) = std::move(test);
+		++generatedTests;
+	}
 
-		DataSet::VMArrangement* start_pos = test.mutable_start_position();
-		DataSet::VMArrangement* end_pos = test.mutable_end_position();
+	dataset.SerializeToOstream(&file);
+}
 
-		for (size_t i = 0; i < problem.vms.size(); ++i) {
-			start_pos->add_vm_server(problem.start_position.vm_server[i]); 
-			end_pos->add_vm_server(problem.end_position.vm_server[i]);
-		}
+void DumpTests(const DataSet::DataSet& dataset, const std::string& path) {
+	std::ofstream file(path, std::ios::binary | std::ios::trunc | std::ios::out);
 
-		*(dataset.add_tests()) = std::move(test);
-		++generatedTests;
+	if (!file.is_open()) {
+		throw std::invalid_argument("Path `" + path + "` seems incorrect for dumping tests");
 	}
 
 	dataset.SerializeToOstream(&file);
@@ -252,23 +490,34 @@ DataSet::DataSet LoadTests(const std::string& path) {
 Problem ConvertTestCaseToProblem(const DataSet::TestCase& test) {
 	Problem result;
 
-	result.vms.resize(test.vms_size());
+	std::vector<VM> vms(test.vms_size());
 	result.server_specs.resize(test.specs_size());
 	result.start_position.vm_server.resize(test.start_position().vm_server_size());
 	result.end_position.vm_server.resize(test.end_position().vm_server_size());
 
 	for (size_t i = 0; i < test.vms_size(); ++i) {
-		result.vms[i].id = test.vms(i).id();
-		result.vms[i].mem = test.vms(i).mem();
-		result.vms[i].cpu = test.vms(i).cpu();
-		result.vms[i].migration_time = test.vms(i).migration_time();
+		vms[i].id = test.vms(i).id();
+		vms[i].mem = test.vms(i).mem();
+		vms[i].cpu = test.vms(i).cpu();
+		vms[i].migration_time = DurationFromUnits(test.vms(i).migration_time());
+		vms[i].disk = test.vms(i).disk();
+		vms[i].net = test.vms(i).net();
+		vms[i].priority = test.vms(i).has_priority() ? test.vms(i).priority() : 1;
+
+		if (test.vms(i).has_deadline()) {
+			vms[i].deadline = DurationFromUnits(test.vms(i).deadline());
+		}
 	}
 
+	result.vms = std::move(vms);
+
 	for (size_t i = 0; i < test.specs_size(); ++i) {
 		result.server_specs[i].mem = test.specs(i).mem();
 		result.server_specs[i].cpu = test.specs(i).cpu();
 		result.server_specs[i].max_in = test.specs(i).max_in();
 		result.server_specs[i].max_out = test.specs(i).max_out();
+		result.server_specs[i].disk = test.specs(i).disk();
+		result.server_specs[i].net = test.specs(i).net();
 	}
 
 	const DataSet::VMArrangement& start_pos = test.start_position();
@@ -279,5 +528,98 @@ Problem ConvertTestCaseToProblem(const DataSet::TestCase& test) {
 		result.end_position.vm_server[i] = end_pos.vm_server(i);
 	}
 
+	if (test.has_topology()) {
+		const DataSet::Topology& topology = test.topology();
+		Topology& target = result.topology;
+
+		target.server_rack.assign(topology.server_rack().begin(), topology.server_rack().end());
+		target.rack_pod.assign(topology.rack_pod().begin(), topology.rack_pod().end());
+		target.pod_uplink_limit.assign(topology.pod_uplink_limit().begin(), topology.pod_uplink_limit().end());
+
+		for (size_t i = 0; i < std::min<size_t>(topology.hop_multiplier_size(), kHopClasses); ++i) {
+			target.hop_multiplier[i] = topology.hop_multiplier(i);
+		}
+
+		if (target.server_rack.size() != result.server_specs.size()) {
+			throw std::invalid_argument("Topology of test #" + std::to_string(test.id()) + " places " +
+				std::to_string(target.server_rack.size()) + " servers in racks, test has " + std::to_string(result.server_specs.size()));
+		}
+		for (uint32_t rack : target.server_rack) {
+			if (rack >= target.rack_pod.size()) {
+				throw std::invalid_argument("Topology of test #" + std::to_string(test.id()) + " has no pod for rack #" +
+					std::to_string(rack));
+			}
+		}
+	}
+
 	return result;
-}
\ No newline at end of file
+}
+
+DataSet::TestCase ConvertProblemToTestCase(const Problem& problem) {
+	DataSet::TestCase test;
+
+	for (size_t i = 0; i < problem.vms.size(); ++i) {
+		DataSet::VM* vm = test.add_vms();
+
+		vm->set_cpu(problem.vms[i].cpu);
+		vm->set_mem(problem.vms[i].mem);
+		vm->set_id(problem.vms[i].id);
+		vm->set_migration_time(TimeToUnits(problem.vms[i].migration_time));
+
+		if (problem.vms[i].disk) {
+			vm->set_disk(problem.vms[i].disk);
+		}
+		if (problem.vms[i].net) {
+			vm->set_net(problem.vms[i].net);
+		}
+		if (problem.vms[i].priority != 1) {
+			vm->set_priority(problem.vms[i].priority);
+		}
+		if (problem.vms[i].deadline != kNoDeadline) {
+			vm->set_deadline(TimeToUnits(problem.vms[i].deadline));
+		}
+	}
+
+	for (size_t i = 0; i < problem.server_specs.size(); ++i) {
+		DataSet::ServerSpec* spec = test.add_specs();
+
+		spec->set_mem(problem.server_specs[i].mem);
+		spec->set_cpu(problem.server_specs[i].cpu);
+		spec->set_max_in(problem.server_specs[i].max_in);
+		spec->set_max_out(problem.server_specs[i].max_out);
+
+		if (problem.server_specs[i].disk) {
+			spec->set_disk(problem.server_specs[i].disk);
+		}
+		if (problem.server_specs[i].net) {
+			spec->set_net(problem.server_specs[i].net);
+		}
+	}
+
+	DataSet::VMArrangement* start_pos = test.mutable_start_position();
+	DataSet::VMArrangement* end_pos = test.mutable_end_position();
+
+	for (size_t i = 0; i < problem.vms.size(); ++i) {
+		start_pos->add_vm_server(problem.start_position.vm_server[i]); 
+		end_pos->add_vm_server(problem.end_position.vm_server[i]);
+	}
+
+	if (!problem.topology.Empty()) {
+		DataSet::Topology* topology = test.mutable_topology();
+
+		for (uint32_t rack : problem.topology.server_rack) {
+			topology->add_server_rack(rack);
+		}
+		for (uint32_t pod : problem.topology.rack_pod) {
+			topology->add_rack_pod(pod);
+		}
+		for (double multiplier : problem.topology.hop_multiplier) {
+			topology->add_hop_multiplier(multiplier);
+		}
+		for (uint32_t limit : problem.topology.pod_uplink_limit) {
+			topology->add_pod_uplink_limit(limit);
+		}
+	}
+
+	return test;
+}
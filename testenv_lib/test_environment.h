@@ -7,7 +7,12 @@
 #include <fstream>
 #include <string>
 
+#include "../common/arena.h"
 #include "../common/metrics.h"
+#include "../common/plan_stream.h"
+#include "../common/workspace.h"
+#include "alloc_profile.h"
+#include "perf_counters.h"
 #include "test_generator.h"
 #include "algo_stat_maker.h"
 
@@ -15,13 +20,16 @@
 #include "../proto/metrics.pb.h"
 
 Problem ConvertTestCaseToProblem(const DataSet::TestCase& test);
+DataSet::TestCase ConvertProblemToTestCase(const Problem& problem); // id is left unset
 
 DataSet::DataSet LoadTests(const std::string& path);
+void DumpTests(const DataSet::DataSet& dataset, const std::string& path);
 
 class TestEnvironment {
 public:
 	using TestPredicateCallback = std::function<bool(const Problem&)>;
-	using AlgorithmCallback = std::function<std::optional<Solution>(const Problem&, AlgoStatMaker*)>;
+	using AlgorithmCallback = std::function<std::optional<Solution>(const Problem&, AlgoStatMaker*, SolverWorkspace*)>;
+	using StreamCallback = std::function<PlanStream(const Problem&, AlgoStatMaker*, SolverWorkspace*)>;
 
 	TestEnvironment(std::unique_ptr<ITestGenerator>&& test_generator);
 
@@ -30,22 +38,77 @@ public:
 	Metrics::MetricsSet RunTestsFromDataSet(DataSet::DataSet dataset, AlgorithmCallback solver, AlgoStatMaker* statmaker = nullptr);
 	void GenerateAndDumpTests(const std::string& path, size_t test_count, TestPredicateCallback callback);
 
+	// solves a problem owned by the caller (e.g. shared by several environments) and appends its
+	// metrics, returns whether it was solved; FinishMeasurements closes the set
+	bool RunTest(
+		const Problem& problem,
+		size_t test_id,
+		const AlgorithmCallback& solver,
+		Metrics::MetricsSet* measurements,
+		AlgoStatMaker* statmaker = nullptr
+	);
+	void FinishMeasurements(Metrics::MetricsSet* measurements, size_t tests, size_t solved) const;
+
+	// like RunTest, but the solution and its metrics come from a previous run (see SolutionCache);
+	// `validate` re-runs the correctness check and recomputes plan metrics
+	bool ReplayTest(
+		const Problem& problem,
+		size_t test_id,
+		const std::optional<Solution>& solution,
+		const Metrics::Metrics& cached,
+		bool validate,
+		Metrics::MetricsSet* measurements
+	);
+	const std::optional<Solution>& GetLastSolution() const;
+
 	// returns bool indicating where this problem can be solved by algorithm or not
 	bool GetStatOnTest(const Problem& problem, AlgorithmCallback solver, AlgoStatMaker* statmaker);
 
+	// every test is solved `warmup` times untimed and then `repetitions` times timed
+	void SetRepetitions(size_t warmup, size_t repetitions);
+
+	// streaming version of the solver: after the timed solves it is run once more up to its first
+	// movement, that time is emitted as TimeToFirstMigrationMs
+	void SetStreamingSolver(StreamCallback stream);
+
+	// hardware counters around solver calls (last repetition) and validation, emitted as per-test
+	// metrics; returns false and keeps measuring time only if the counters cannot be opened
+	bool EnablePerfCounters();
+
 	void PrintMeasurements(std::ostream& out) const;
 	void ClearMeasurements();
+	void MergeMeasurements(const TestEnvironment& other); // e.g. environments of worker threads
 
 private:
 
+	void SolveCurrentProblem(const AlgorithmCallback& solver, AlgoStatMaker* statmaker);
 	void CheckCorrectness() const;
-	void CountMetrics(Metrics::MetricsSet* measurements);
+	void ValidateSolution(); // CheckCorrectness under the counters
+	void CountMetrics(Metrics::MetricsSet* measurements, size_t test_id);
+	void AppendPlanMetrics(Metrics::Metrics* test_measurements);
+	void AppendPerfMetrics(
+		Metrics::Metrics* test_measurements,
+		const std::string& prefix,
+		const std::optional<PerfCounters::Values>& values
+	);
 
 private:
-	Problem problem_;
+	Problem owned_problem_; // generated or converted by the environment itself
+	const Problem* problem_ = nullptr; // the one being solved
 	std::optional<Solution> solution_;
 
-	std::vector<std::unique_ptr<IMetric>> metrics_;
-	std::vector<MetricsAccumulator> accumulators_;
+	std::vector<MetricsAccumulator> accumulators_; // one per metric of PlanMetrics
+	MetricsAccumulator solve_time_;
+	MetricsAccumulator test_solve_time_; // repetitions of the current test
+	MetricsAccumulator first_migration_time_;
+	std::optional<long double> test_first_migration_time_;
+	StreamCallback stream_; // empty unless set
+	AllocProfile::Counters allocations_; // last repetition of the current test
+	std::unique_ptr<PerfCounters> perf_; // null unless enabled and available
+	std::optional<PerfCounters::Values> solver_counters_; // last repetition of the current test
+	std::optional<PerfCounters::Values> validator_counters_;
+	size_t warmup_ = 0;
+	size_t repetitions_ = 1;
 	std::unique_ptr<ITestGenerator> generator_;
+	SolverWorkspace workspace_; // reused by all solver calls
 };
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "test_generator.h"
 
+#include <numeric>
 #include <stdexcept>
 #include <glog/logging.h>
 
@@ -77,6 +78,7 @@ Problem RealLifeGenerator::Generate() {
 
 	Problem result;
 	result.server_specs.resize(server_count);
+	std::vector<VM> vms;
 	size_t vm_count = 0;
 
 	std::uniform_real_distribution<double> unif_gen(0, 1.0); 
@@ -109,7 +111,7 @@ Problem RealLifeGenerator::Generate() {
 						cpu, 
 						mem,
 						vm_count++,
-						mem_mig_velocity * static_cast<long double>(mem)
+						DurationFromUnits(mem_mig_velocity * mem)
 					});
 				}
 			}
@@ -136,14 +138,15 @@ Problem RealLifeGenerator::Generate() {
 			freecpu -= new_vm->cpu;
 			freemem -= new_vm->mem;
 
-			result.vms.push_back(*new_vm);
+			vms.push_back(*new_vm);
 			result.start_position.vm_server.push_back(i);
 		}
 	}
 
 	result.end_position = result.start_position;
 
-	std::vector<VM> vms_for_move = result.vms;
+	std::vector<VM> vms_for_move = vms;
+	result.vms = std::move(vms);
 
 	std::shuffle(vms_for_move.begin(), vms_for_move.end(), rnd_);
 
@@ -269,4 +272,394 @@ Problem CyclesGenerator::Generate() {
 	}
 
 	return problem;
-}
\ No newline at end of file
+}
+std::vector<Resources> ServerLoads(const Problem& problem, const VMArrangement& arrangement) {
+	std::vector<Resources> loads(problem.server_specs.size());
+	for (const VM& vm : problem.vms) {
+		loads[arrangement.vm_server[vm.id]] += Demand(vm);
+	}
+	return loads;
+}
+
+bool FitsOnServer(const Problem& problem, const std::vector<Resources>& loads, size_t server, const VM& vm) {
+	Resources load = loads[server];
+	load += Demand(vm);
+	return load.FitsInto(Capacity(problem.server_specs[server]));
+}
+
+// same spec as the buffer server of RealLifeGenerator
+size_t AddSpareServer(Problem* problem, std::vector<Resources>* loads) {
+	problem->server_specs.push_back(ServerSpec{512, 128, 1, 1});
+	loads->emplace_back();
+	return problem->server_specs.size() - 1;
+}
+
+// moves `vm` of the end arrangement to the first server of `order` it fits into
+void PlaceFirstFit(Problem* problem, std::vector<Resources>* loads, const std::vector<size_t>& order, const VM& vm) {
+	size_t target = problem->server_specs.size();
+	for (size_t server : order) {
+		if (FitsOnServer(*problem, *loads, server, vm)) {
+			target = server;
+			break;
+		}
+	}
+
+	if (target == problem->server_specs.size()) {
+		target = AddSpareServer(problem, loads);
+	}
+
+	(*loads)[problem->end_position.vm_server[vm.id]] -= Demand(vm);
+	(*loads)[target] += Demand(vm);
+	problem->end_position.vm_server[vm.id] = target;
+}
+
+std::vector<std::vector<size_t>> VMsByServer(const Problem& problem, const VMArrangement& arrangement) {
+	std::vector<std::vector<size_t>> result(problem.server_specs.size());
+	for (const VM& vm : problem.vms) {
+		result[arrangement.vm_server[vm.id]].push_back(vm.id);
+	}
+	return result;
+}
+
+double MemoryLoad(const Problem& problem, const std::vector<Resources>& loads, size_t server) {
+	return static_cast<double>(loads[server][kMem]) / problem.server_specs[server].mem;
+}
+
+EvacuationGenerator::EvacuationGenerator(
+	size_t seed,
+	size_t drain_percentage,
+	size_t servers_quantity_min,
+	size_t servers_quantity_max
+)
+	: cluster_generator_(seed, 0, servers_quantity_min, servers_quantity_max)
+	, drain_percentage_(drain_percentage)
+	, rnd_(seed)
+{
+}
+
+Problem EvacuationGenerator::Generate() {
+	Problem problem = cluster_generator_.Generate();
+	std::vector<Resources> loads = ServerLoads(problem, problem.end_position);
+
+	std::vector<size_t> order(problem.server_specs.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::shuffle(order.begin(), order.end(), rnd_);
+
+	size_t drained = std::max<size_t>(1, order.size() * drain_percentage_ / 100);
+	std::vector<size_t> drain(order.begin(), order.begin() + drained);
+	order.erase(order.begin(), order.begin() + drained);
+
+	std::vector<std::vector<size_t>> server_vms = VMsByServer(problem, problem.start_position);
+	for (size_t server : drain) {
+		for (size_t vm_id : server_vms[server]) {
+			PlaceFirstFit(&problem, &loads, order, problem.vms[vm_id]);
+		}
+	}
+
+	return problem;
+}
+
+RollingUpgradeGenerator::RollingUpgradeGenerator(
+	size_t seed,
+	size_t rack_size,
+	size_t batch_racks,
+	size_t servers_quantity_min,
+	size_t servers_quantity_max
+)
+	: cluster_generator_(seed, 0, servers_quantity_min, servers_quantity_max)
+	, rack_size_(std::max<size_t>(1, rack_size))
+	, batch_racks_(std::max<size_t>(1, batch_racks))
+	, rnd_(seed)
+{
+}
+
+Problem RollingUpgradeGenerator::Generate() {
+	Problem problem = cluster_generator_.Generate();
+	size_t servers = problem.server_specs.size();
+	size_t batch_size = rack_size_ * batch_racks_;
+
+	if (servers < 3 * batch_size) {
+		throw std::runtime_error("Cluster of " + std::to_string(servers) + " servers is too small for upgrade batches of " +
+			std::to_string(batch_size));
+	}
+
+	// batches [previous, previous + batch_size) and [current, current + batch_size)
+	size_t batches = servers / batch_size;
+	size_t previous = RandomIntFromRange(0, batches - 2, rnd_) * batch_size;
+	size_t current = previous + batch_size;
+
+	std::vector<size_t> upgraded, rest;
+	for (size_t server = 0; server < servers; ++server) {
+		if (server >= previous && server < current) {
+			upgraded.push_back(server);
+		} else if (server < previous || server >= current + batch_size) {
+			rest.push_back(server);
+		}
+	}
+	std::shuffle(rest.begin(), rest.end(), rnd_);
+
+	// the previous wave left the upgraded racks empty
+	std::vector<Resources> loads = ServerLoads(problem, problem.end_position);
+	std::vector<std::vector<size_t>> server_vms = VMsByServer(problem, problem.start_position);
+
+	for (size_t server : upgraded) {
+		for (size_t vm_id : server_vms[server]) {
+			PlaceFirstFit(&problem, &loads, rest, problem.vms[vm_id]);
+		}
+	}
+	problem.start_position = problem.end_position;
+
+	std::vector<size_t> order = upgraded;
+	order.insert(order.end(), rest.begin(), rest.end());
+
+	for (size_t server = current; server < current + batch_size; ++server) {
+		for (size_t vm_id : server_vms[server]) {
+			PlaceFirstFit(&problem, &loads, order, problem.vms[vm_id]);
+		}
+	}
+
+	return problem;
+}
+
+ConsolidationGenerator::ConsolidationGenerator(
+	size_t seed,
+	size_t release_percentage,
+	size_t servers_quantity_min,
+	size_t servers_quantity_max
+)
+	: cluster_generator_(seed, 0, servers_quantity_min, servers_quantity_max)
+	, release_percentage_(release_percentage)
+	, rnd_(seed)
+{
+}
+
+Problem ConsolidationGenerator::Generate() {
+	Problem problem = cluster_generator_.Generate();
+	std::vector<Resources> loads = ServerLoads(problem, problem.end_position);
+	std::vector<std::vector<size_t>> server_vms = VMsByServer(problem, problem.start_position);
+
+	std::vector<size_t> by_load(problem.server_specs.size());
+	std::iota(by_load.begin(), by_load.end(), 0);
+	std::shuffle(by_load.begin(), by_load.end(), rnd_); // ties of empty servers
+	std::stable_sort(by_load.begin(), by_load.end(), [&](size_t lhs, size_t rhs) {
+		return MemoryLoad(problem, loads, lhs) < MemoryLoad(problem, loads, rhs);
+	});
+
+	size_t to_release = by_load.size() * release_percentage_ / 100;
+	std::vector<bool> released(problem.server_specs.size(), false);
+
+	for (size_t server : by_load) {
+		if (to_release == 0) {
+			break;
+		}
+		if (server_vms[server].empty()) {
+			continue; // nothing to consolidate on an idle server
+		}
+
+		// best fit: the fullest remaining server with room, biggest VMs first
+		std::vector<size_t> vms = server_vms[server];
+		std::sort(vms.begin(), vms.end(), [&](size_t lhs, size_t rhs) {
+			return problem.vms[lhs].mem > problem.vms[rhs].mem;
+		});
+
+		std::vector<Resources> trial = loads;
+		std::vector<std::pair<size_t, size_t>> moves; // {vm, server}
+		released[server] = true;
+
+		for (size_t vm_id : vms) {
+			const VM& vm = problem.vms[vm_id];
+			std::optional<size_t> target;
+
+			for (size_t candidate = 0; candidate < trial.size(); ++candidate) {
+				if (released[candidate] || !FitsOnServer(problem, trial, candidate, vm)) {
+					continue;
+				}
+				if (!target || MemoryLoad(problem, trial, candidate) > MemoryLoad(problem, trial, *target)) {
+					target = candidate;
+				}
+			}
+
+			if (!target) {
+				break;
+			}
+
+			trial[server] -= Demand(vm);
+			trial[*target] += Demand(vm);
+			moves.emplace_back(vm_id, *target);
+		}
+
+		if (moves.size() != vms.size()) {
+			released[server] = false; // does not fit into the rest, stays as it is
+			continue;
+		}
+
+		loads = std::move(trial);
+		for (auto [vm_id, target] : moves) {
+			problem.end_position.vm_server[vm_id] = target;
+		}
+		--to_release;
+	}
+
+	return problem;
+}
+
+RebalanceGenerator::RebalanceGenerator(
+	size_t seed,
+	size_t hot_percentage,
+	size_t servers_quantity_min,
+	size_t servers_quantity_max
+)
+	: cluster_generator_(seed, 0, servers_quantity_min, servers_quantity_max)
+	, hot_percentage_(hot_percentage)
+	, rnd_(seed)
+{
+}
+
+Problem RebalanceGenerator::Generate() {
+	Problem problem = cluster_generator_.Generate();
+	std::vector<Resources> loads = ServerLoads(problem, problem.end_position);
+	std::vector<std::vector<size_t>> server_vms = VMsByServer(problem, problem.start_position);
+
+	size_t total_mem = 0, used_mem = 0;
+	for (size_t server = 0; server < loads.size(); ++server) {
+		total_mem += problem.server_specs[server].mem;
+		used_mem += loads[server][kMem];
+	}
+	double mean_load = static_cast<double>(used_mem) / total_mem;
+
+	std::vector<size_t> by_load(problem.server_specs.size());
+	std::iota(by_load.begin(), by_load.end(), 0);
+	std::shuffle(by_load.begin(), by_load.end(), rnd_);
+	std::stable_sort(by_load.begin(), by_load.end(), [&](size_t lhs, size_t rhs) {
+		return MemoryLoad(problem, loads, lhs) > MemoryLoad(problem, loads, rhs);
+	});
+
+	size_t hot_count = std::max<size_t>(1, by_load.size() * hot_percentage_ / 100);
+	std::vector<bool> hot(problem.server_specs.size(), false);
+	for (size_t i = 0; i < hot_count; ++i) {
+		hot[by_load[i]] = true;
+	}
+
+	for (size_t i = 0; i < hot_count; ++i) {
+		size_t server = by_load[i];
+
+		// the cheapest migrations first
+		std::vector<size_t> vms = server_vms[server];
+		std::sort(vms.begin(), vms.end(), [&](size_t lhs, size_t rhs) {
+			return problem.vms[lhs].mem < problem.vms[rhs].mem;
+		});
+
+		for (size_t vm_id : vms) {
+			if (MemoryLoad(problem, loads, server) <= mean_load) {
+				break;
+			}
+
+			const VM& vm = problem.vms[vm_id];
+			std::optional<size_t> target;
+
+			for (size_t candidate = 0; candidate < loads.size(); ++candidate) {
+				if (hot[candidate] || !FitsOnServer(problem, loads, candidate, vm)) {
+					continue;
+				}
+				if (!target || MemoryLoad(problem, loads, candidate) < MemoryLoad(problem, loads, *target)) {
+					target = candidate;
+				}
+			}
+
+			if (!target) {
+				break;
+			}
+
+			loads[server] -= Demand(vm);
+			loads[*target] += Demand(vm);
+			problem.end_position.vm_server[vm_id] = *target;
+		}
+	}
+
+	return problem;
+}
+
+FatTreeGenerator::FatTreeGenerator(
+	std::unique_ptr<ITestGenerator>&& base,
+	size_t rack_size,
+	size_t racks_per_pod,
+	double intra_pod_multiplier,
+	double cross_pod_multiplier,
+	size_t uplink_limit
+)
+	: base_(std::move(base))
+	, rack_size_(std::max<size_t>(1, rack_size))
+	, racks_per_pod_(std::max<size_t>(1, racks_per_pod))
+	, intra_pod_multiplier_(intra_pod_multiplier)
+	, cross_pod_multiplier_(cross_pod_multiplier)
+	, uplink_limit_(uplink_limit)
+{
+}
+
+Problem FatTreeGenerator::Generate() {
+	Problem problem = base_->Generate();
+	Topology& topology = problem.topology;
+
+	size_t servers = problem.server_specs.size();
+	size_t racks = (servers + rack_size_ - 1) / rack_size_;
+	size_t pods = (racks + racks_per_pod_ - 1) / racks_per_pod_;
+
+	topology.server_rack.resize(servers);
+	for (size_t server = 0; server < servers; ++server) {
+		topology.server_rack[server] = server / rack_size_;
+	}
+
+	topology.rack_pod.resize(racks);
+	for (size_t rack = 0; rack < racks; ++rack) {
+		topology.rack_pod[rack] = rack / racks_per_pod_;
+	}
+
+	topology.hop_multiplier = {1, intra_pod_multiplier_, cross_pod_multiplier_};
+	topology.pod_uplink_limit.assign(pods, uplink_limit_);
+
+	return problem;
+}
+
+SLAGenerator::SLAGenerator(
+	std::unique_ptr<ITestGenerator>&& base,
+	size_t seed,
+	size_t critical_percentage,
+	double critical_priority,
+	double deadline_slack_min,
+	double deadline_slack_max
+)
+	: base_(std::move(base))
+	, rnd_(seed)
+	, critical_percentage_(critical_percentage)
+	, critical_priority_(critical_priority)
+	, deadline_slack_min_(deadline_slack_min)
+	, deadline_slack_max_(std::max(deadline_slack_min, deadline_slack_max))
+{
+}
+
+Problem SLAGenerator::Generate() {
+	Problem problem = base_->Generate();
+
+	std::vector<size_t> moving;
+	for (const auto& vm : problem.vms) {
+		if (problem.start_position.vm_server[vm.id] != problem.end_position.vm_server[vm.id]) {
+			moving.push_back(vm.id);
+		}
+	}
+	std::shuffle(moving.begin(), moving.end(), rnd_);
+	moving.resize(moving.size() * critical_percentage_ / 100);
+
+	std::vector<VM> vms = problem.vms.ToVector();
+	std::uniform_real_distribution<double> slack(deadline_slack_min_, deadline_slack_max_);
+	for (size_t vm_id : moving) {
+		VM& vm = vms[vm_id];
+		TimeMoment duration = MigrationDuration(
+			problem, vm_id, problem.start_position.vm_server[vm_id], problem.end_position.vm_server[vm_id]);
+
+		vm.priority = critical_priority_;
+		vm.deadline = static_cast<TimeMoment>(duration * slack(rnd_));
+	}
+	problem.vms = std::move(vms);
+
+	return problem;
+}
@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <iostream>
 #include <map>
+#include <memory>
 #include <optional>
 #include <random>
 #include <utility>
@@ -58,4 +59,152 @@ private:
 	RealLifeGenerator test_generator_;
 	size_t diff_percentage_cycles_;
 	std::mt19937 rnd_;
+};
+/*
+	Scenario generators: a cluster filled like RealLifeGenerator (without its random diff) is
+	rearranged the way real migration waves do it. VMs which do not fit into the cluster any
+	more go to spare servers appended at the end.
+*/
+
+class EvacuationGenerator final : public ITestGenerator {
+/*
+	Maintenance drain: `drain_percentage` of the hosts are emptied, their VMs go first fit to
+	the rest of the cluster.
+*/
+public:
+	EvacuationGenerator(
+		size_t seed = 42,
+		size_t drain_percentage = 5,
+		size_t servers_quantity_min = 100,
+		size_t servers_quantity_max = 1000
+	);
+
+	Problem Generate() override;
+
+private:
+	RealLifeGenerator cluster_generator_;
+	size_t drain_percentage_;
+	std::mt19937 rnd_;
+};
+
+class RollingUpgradeGenerator final : public ITestGenerator {
+/*
+	One wave of an upgrade rolled over racks of `rack_size` consecutive servers: racks of the
+	previous batch are already upgraded and empty, racks of the current batch are drained into
+	them, the rest of the cluster takes what does not fit.
+*/
+public:
+	RollingUpgradeGenerator(
+		size_t seed = 42,
+		size_t rack_size = 20,
+		size_t batch_racks = 2,
+		size_t servers_quantity_min = 100,
+		size_t servers_quantity_max = 1000
+	);
+
+	Problem Generate() override;
+
+private:
+	RealLifeGenerator cluster_generator_;
+	size_t rack_size_;
+	size_t batch_racks_;
+	std::mt19937 rnd_;
+};
+
+class ConsolidationGenerator final : public ITestGenerator {
+/*
+	Fragmented cluster packed tighter: the least loaded servers are emptied one by one into
+	the best fitting remaining ones, up to `release_percentage` of the servers.
+*/
+public:
+	ConsolidationGenerator(
+		size_t seed = 42,
+		size_t release_percentage = 20,
+		size_t servers_quantity_min = 100,
+		size_t servers_quantity_max = 1000
+	);
+
+	Problem Generate() override;
+
+private:
+	RealLifeGenerator cluster_generator_;
+	size_t release_percentage_;
+	std::mt19937 rnd_;
+};
+
+class RebalanceGenerator final : public ITestGenerator {
+/*
+	Hot spots cooled down: on the `hot_percentage` most loaded servers the smallest VMs move
+	to the least loaded servers until the memory load is at the cluster mean.
+*/
+public:
+	RebalanceGenerator(
+		size_t seed = 42,
+		size_t hot_percentage = 10,
+		size_t servers_quantity_min = 100,
+		size_t servers_quantity_max = 1000
+	);
+
+	Problem Generate() override;
+
+private:
+	RealLifeGenerator cluster_generator_;
+	size_t hot_percentage_;
+	std::mt19937 rnd_;
+};
+
+class FatTreeGenerator final : public ITestGenerator {
+/*
+	Problems of another generator placed into a fat tree: racks of `rack_size` consecutive
+	servers, pods of `racks_per_pod` racks. Moves between racks of a pod take `intra_pod_multiplier`
+	times longer than inside a rack, moves between pods `cross_pod_multiplier` times, and every
+	pod uplink carries at most `uplink_limit` transfers at once.
+*/
+public:
+	FatTreeGenerator(
+		std::unique_ptr<ITestGenerator>&& base,
+		size_t rack_size = 20,
+		size_t racks_per_pod = 8,
+		double intra_pod_multiplier = 2,
+		double cross_pod_multiplier = 4,
+		size_t uplink_limit = 8
+	);
+
+	Problem Generate() override;
+
+private:
+	std::unique_ptr<ITestGenerator> base_;
+	size_t rack_size_;
+	size_t racks_per_pod_;
+	double intra_pod_multiplier_;
+	double cross_pod_multiplier_;
+	size_t uplink_limit_;
+};
+
+class SLAGenerator final : public ITestGenerator {
+/*
+	Problems of another generator where `critical_percentage` percents of the migrating VMs
+	carry weight `critical_priority` and must be in place within a random `deadline_slack_min`
+	to `deadline_slack_max` times their own migration time. The rest keep the default weight
+	and no deadline.
+*/
+public:
+	SLAGenerator(
+		std::unique_ptr<ITestGenerator>&& base,
+		size_t seed,
+		size_t critical_percentage = 10,
+		double critical_priority = 10,
+		double deadline_slack_min = 2,
+		double deadline_slack_max = 10
+	);
+
+	Problem Generate() override;
+
+private:
+	std::unique_ptr<ITestGenerator> base_;
+	std::mt19937 rnd_;
+	size_t critical_percentage_;
+	double critical_priority_;
+	double deadline_slack_min_;
+	double deadline_slack_max_;
 };
\ No newline at end of file